@@ -9,6 +9,7 @@
 #include "graph.hpp"
 #include "hypergraph.hpp"
 #include "utils.hpp"
+#include "pmc_store.hpp"
 
 namespace triangulator {
 namespace {
@@ -21,7 +22,7 @@ std::string TmpInstance(int a, int b, int c) {
 } // namespace
 
 namespace asp_enumerator {
-std::vector<std::vector<int>> TreewidthPmcs(const Graph& graph, int size) {
+PmcStore TreewidthPmcs(const Graph& graph, int size) {
   std::string tmp_file_in = TmpInstance(graph.n(), graph.m(), size);
   std::string tmp_file_out = TmpInstance(graph.n(), graph.m(), size+1000000);
   std::ofstream out(tmp_file_in);
@@ -33,7 +34,7 @@ std::vector<std::vector<int>> TreewidthPmcs(const Graph& graph, int size) {
   out.close();
   system(("solvers/clingo/clingo "+tmp_file_in+" solvers/clingo/treewidth_encoding.lp 0 > "+tmp_file_out).c_str());
   std::ifstream in(tmp_file_out);
-  std::vector<std::vector<int>> ret;
+  PmcStore ret;
   std::string tmp;
   while (std::getline(in, tmp)) {
     if ((int)tmp.size() > 7 && tmp.substr(0, 7) == "Answer:") {
@@ -58,7 +59,7 @@ std::vector<std::vector<int>> TreewidthPmcs(const Graph& graph, int size) {
       }
       assert(!paren);
       assert((int)pmc.size() > 0);
-      ret.push_back(pmc);
+      ret.Add(pmc);
     }
   }
   in.close();
@@ -66,7 +67,7 @@ std::vector<std::vector<int>> TreewidthPmcs(const Graph& graph, int size) {
   system(("rm "+tmp_file_out).c_str());
   return ret;
 }
-std::vector<std::vector<int>> HypertreewidthPmcs(const HyperGraph& hypergraph, int size) {
+PmcStore HypertreewidthPmcs(const HyperGraph& hypergraph, int size) {
   std::string tmp_file_in = TmpInstance(hypergraph.n(), hypergraph.m(), size+100);
   std::string tmp_file_out = TmpInstance(hypergraph.n(), hypergraph.m(), size+1000);
   std::ofstream out(tmp_file_in);
@@ -84,7 +85,7 @@ std::vector<std::vector<int>> HypertreewidthPmcs(const HyperGraph& hypergraph, i
   out.close();
   system(("solvers/clingo/clingo "+tmp_file_in+" solvers/clingo/hypertreewidth_encoding.lp 0 > "+tmp_file_out).c_str());
   std::ifstream in(tmp_file_out);
-  std::vector<std::vector<int>> ret;
+  PmcStore ret;
   std::string tmp;
   while (std::getline(in, tmp)) {
     if ((int)tmp.size() > 7 && tmp.substr(0, 7) == "Answer:") {
@@ -109,14 +110,11 @@ std::vector<std::vector<int>> HypertreewidthPmcs(const HyperGraph& hypergraph, i
       }
       assert(!paren);
       assert((int)pmc.size() > 0);
-      ret.push_back(pmc);
+      ret.Add(pmc);
     }
   }
   in.close();
-  for (auto& pmc : ret) {
-    sort(pmc.begin(), pmc.end());
-  }
-  utils::SortAndDedup(ret);
+  ret.SortAndDedup();
   system(("rm "+tmp_file_in).c_str());
   system(("rm "+tmp_file_out).c_str());
   return ret;
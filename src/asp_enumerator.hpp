@@ -4,10 +4,11 @@
 
 #include "graph.hpp"
 #include "hypergraph.hpp"
+#include "pmc_store.hpp"
 
 namespace triangulator {
 namespace asp_enumerator {
-std::vector<std::vector<int>> TreewidthPmcs(const Graph& graph, int size);
-std::vector<std::vector<int>> HypertreewidthPmcs(const HyperGraph& hypergraph, int size);
+PmcStore TreewidthPmcs(const Graph& graph, int size);
+PmcStore HypertreewidthPmcs(const HyperGraph& hypergraph, int size);
 } // namespace asp_enumerator
 } // namespace triangulator
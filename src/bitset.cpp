@@ -0,0 +1 @@
+#include "bitset.hpp"
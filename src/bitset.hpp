@@ -0,0 +1,366 @@
+#pragma once
+
+// Sets of integers 0..n-1 packed into 64-bit words. Used for word-parallel graph operations.
+// Bitset has its width chosen at runtime, FixedBitset<W> is a branch-free version for n <= 64*W.
+// Both also operate directly on rows of raw words of the same width, such as the rows of a packed adjacency matrix.
+
+#include <vector>
+#include <cstdint>
+#include <cassert>
+
+namespace triangulator {
+// Interface
+class Bitset {
+public:
+  Bitset();
+  explicit Bitset(int n);
+  void Resize(int n);
+  // Resizes to n and inserts all of 0..n-1
+  void Fill(int n);
+  int Words() const;
+
+  bool Has(int v) const;
+  void Set(int v);
+  void Reset(int v);
+  void Clear();
+  bool Empty() const;
+  int Count() const;
+  // Returns the smallest element, or -1 if the set is empty
+  int First() const;
+  // Returns the smallest element larger than v, or -1 if there is none
+  int Next(int v) const;
+  std::vector<int> Elements() const;
+
+  Bitset& operator|=(const Bitset& rhs);
+  Bitset& operator&=(const Bitset& rhs);
+  // Removes the elements of rhs from this set
+  Bitset& operator-=(const Bitset& rhs);
+  bool operator==(const Bitset& rhs) const;
+  bool operator!=(const Bitset& rhs) const;
+  bool Intersects(const Bitset& rhs) const;
+  bool IsSubsetOf(const Bitset& rhs) const;
+  // Sets this to (a & b) and returns whether the result is non-empty
+  bool SetIntersection(const Bitset& a, const Bitset& b);
+
+  void Union(const uint64_t* row);
+  bool IsSubsetOf(const uint64_t* row) const;
+  bool SetIntersection(const uint64_t* a, const Bitset& b);
+
+  Bitset(const Bitset& rhs) = default;
+  Bitset& operator=(const Bitset& rhs) = default;
+private:
+  std::vector<uint64_t> words_;
+};
+
+template<int W>
+class FixedBitset {
+public:
+  FixedBitset();
+  explicit FixedBitset(int n);
+  void Fill(int n);
+
+  bool Has(int v) const;
+  void Set(int v);
+  void Reset(int v);
+  void Clear();
+  bool Empty() const;
+  int First() const;
+  int Next(int v) const;
+  std::vector<int> Elements() const;
+
+  FixedBitset& operator|=(const FixedBitset& rhs);
+  FixedBitset& operator-=(const FixedBitset& rhs);
+  bool operator==(const FixedBitset& rhs) const;
+  bool IsSubsetOf(const FixedBitset& rhs) const;
+
+  void Union(const uint64_t* row);
+  bool IsSubsetOf(const uint64_t* row) const;
+  bool SetIntersection(const uint64_t* a, const FixedBitset& b);
+private:
+  uint64_t words_[W];
+};
+
+
+// Implementation
+inline Bitset::Bitset() { }
+
+inline Bitset::Bitset(int n) : words_((n + 63) / 64) { }
+
+inline void Bitset::Resize(int n) {
+  words_.assign((n + 63) / 64, 0);
+}
+
+inline void Bitset::Fill(int n) {
+  words_.assign((n + 63) / 64, ~(uint64_t)0);
+  if (n & 63) words_.back() = ((uint64_t)1 << (n & 63)) - 1;
+}
+
+inline int Bitset::Words() const {
+  return words_.size();
+}
+
+inline bool Bitset::Has(int v) const {
+  return (words_[v >> 6] >> (v & 63)) & 1;
+}
+
+inline void Bitset::Set(int v) {
+  words_[v >> 6] |= (uint64_t)1 << (v & 63);
+}
+
+inline void Bitset::Reset(int v) {
+  words_[v >> 6] &= ~((uint64_t)1 << (v & 63));
+}
+
+inline void Bitset::Clear() {
+  for (uint64_t& w : words_) w = 0;
+}
+
+inline bool Bitset::Empty() const {
+  for (uint64_t w : words_) {
+    if (w) return false;
+  }
+  return true;
+}
+
+inline int Bitset::Count() const {
+  int count = 0;
+  for (uint64_t w : words_) count += __builtin_popcountll(w);
+  return count;
+}
+
+inline int Bitset::First() const {
+  for (int i = 0; i < (int)words_.size(); i++) {
+    if (words_[i]) return i * 64 + __builtin_ctzll(words_[i]);
+  }
+  return -1;
+}
+
+inline int Bitset::Next(int v) const {
+  v++;
+  int i = v >> 6;
+  if (i >= (int)words_.size()) return -1;
+  uint64_t w = words_[i] & (~(uint64_t)0 << (v & 63));
+  while (true) {
+    if (w) return i * 64 + __builtin_ctzll(w);
+    i++;
+    if (i >= (int)words_.size()) return -1;
+    w = words_[i];
+  }
+}
+
+inline std::vector<int> Bitset::Elements() const {
+  std::vector<int> elements;
+  for (int i = 0; i < (int)words_.size(); i++) {
+    uint64_t w = words_[i];
+    while (w) {
+      elements.push_back(i * 64 + __builtin_ctzll(w));
+      w &= w - 1;
+    }
+  }
+  return elements;
+}
+
+inline Bitset& Bitset::operator|=(const Bitset& rhs) {
+  assert(words_.size() == rhs.words_.size());
+  for (int i = 0; i < (int)words_.size(); i++) words_[i] |= rhs.words_[i];
+  return *this;
+}
+
+inline Bitset& Bitset::operator&=(const Bitset& rhs) {
+  assert(words_.size() == rhs.words_.size());
+  for (int i = 0; i < (int)words_.size(); i++) words_[i] &= rhs.words_[i];
+  return *this;
+}
+
+inline Bitset& Bitset::operator-=(const Bitset& rhs) {
+  assert(words_.size() == rhs.words_.size());
+  for (int i = 0; i < (int)words_.size(); i++) words_[i] &= ~rhs.words_[i];
+  return *this;
+}
+
+inline bool Bitset::operator==(const Bitset& rhs) const {
+  return words_ == rhs.words_;
+}
+
+inline bool Bitset::operator!=(const Bitset& rhs) const {
+  return words_ != rhs.words_;
+}
+
+inline bool Bitset::Intersects(const Bitset& rhs) const {
+  assert(words_.size() == rhs.words_.size());
+  for (int i = 0; i < (int)words_.size(); i++) {
+    if (words_[i] & rhs.words_[i]) return true;
+  }
+  return false;
+}
+
+inline bool Bitset::IsSubsetOf(const Bitset& rhs) const {
+  assert(words_.size() == rhs.words_.size());
+  for (int i = 0; i < (int)words_.size(); i++) {
+    if (words_[i] & ~rhs.words_[i]) return false;
+  }
+  return true;
+}
+
+inline bool Bitset::SetIntersection(const Bitset& a, const Bitset& b) {
+  assert(words_.size() == a.words_.size() && words_.size() == b.words_.size());
+  uint64_t any = 0;
+  for (int i = 0; i < (int)words_.size(); i++) {
+    words_[i] = a.words_[i] & b.words_[i];
+    any |= words_[i];
+  }
+  return any != 0;
+}
+
+inline void Bitset::Union(const uint64_t* row) {
+  for (int i = 0; i < (int)words_.size(); i++) words_[i] |= row[i];
+}
+
+inline bool Bitset::IsSubsetOf(const uint64_t* row) const {
+  for (int i = 0; i < (int)words_.size(); i++) {
+    if (words_[i] & ~row[i]) return false;
+  }
+  return true;
+}
+
+inline bool Bitset::SetIntersection(const uint64_t* a, const Bitset& b) {
+  assert(words_.size() == b.words_.size());
+  uint64_t any = 0;
+  for (int i = 0; i < (int)words_.size(); i++) {
+    words_[i] = a[i] & b.words_[i];
+    any |= words_[i];
+  }
+  return any != 0;
+}
+
+template<int W>
+FixedBitset<W>::FixedBitset() {
+  Clear();
+}
+
+template<int W>
+FixedBitset<W>::FixedBitset(int n) {
+  assert(n <= 64 * W);
+  Clear();
+}
+
+template<int W>
+void FixedBitset<W>::Fill(int n) {
+  assert(n <= 64 * W);
+  for (int i = 0; i < W; i++) {
+    if (64 * (i + 1) <= n) words_[i] = ~(uint64_t)0;
+    else if (64 * i >= n) words_[i] = 0;
+    else words_[i] = ((uint64_t)1 << (n & 63)) - 1;
+  }
+}
+
+template<int W>
+bool FixedBitset<W>::Has(int v) const {
+  return (words_[v >> 6] >> (v & 63)) & 1;
+}
+
+template<int W>
+void FixedBitset<W>::Set(int v) {
+  words_[v >> 6] |= (uint64_t)1 << (v & 63);
+}
+
+template<int W>
+void FixedBitset<W>::Reset(int v) {
+  words_[v >> 6] &= ~((uint64_t)1 << (v & 63));
+}
+
+template<int W>
+void FixedBitset<W>::Clear() {
+  for (int i = 0; i < W; i++) words_[i] = 0;
+}
+
+template<int W>
+bool FixedBitset<W>::Empty() const {
+  uint64_t any = 0;
+  for (int i = 0; i < W; i++) any |= words_[i];
+  return any == 0;
+}
+
+template<int W>
+int FixedBitset<W>::First() const {
+  for (int i = 0; i < W; i++) {
+    if (words_[i]) return i * 64 + __builtin_ctzll(words_[i]);
+  }
+  return -1;
+}
+
+template<int W>
+int FixedBitset<W>::Next(int v) const {
+  v++;
+  int i = v >> 6;
+  if (i >= W) return -1;
+  uint64_t w = words_[i] & (~(uint64_t)0 << (v & 63));
+  while (true) {
+    if (w) return i * 64 + __builtin_ctzll(w);
+    i++;
+    if (i >= W) return -1;
+    w = words_[i];
+  }
+}
+
+template<int W>
+std::vector<int> FixedBitset<W>::Elements() const {
+  std::vector<int> elements;
+  for (int i = 0; i < W; i++) {
+    uint64_t w = words_[i];
+    while (w) {
+      elements.push_back(i * 64 + __builtin_ctzll(w));
+      w &= w - 1;
+    }
+  }
+  return elements;
+}
+
+template<int W>
+FixedBitset<W>& FixedBitset<W>::operator|=(const FixedBitset<W>& rhs) {
+  for (int i = 0; i < W; i++) words_[i] |= rhs.words_[i];
+  return *this;
+}
+
+template<int W>
+FixedBitset<W>& FixedBitset<W>::operator-=(const FixedBitset<W>& rhs) {
+  for (int i = 0; i < W; i++) words_[i] &= ~rhs.words_[i];
+  return *this;
+}
+
+template<int W>
+bool FixedBitset<W>::operator==(const FixedBitset<W>& rhs) const {
+  uint64_t diff = 0;
+  for (int i = 0; i < W; i++) diff |= words_[i] ^ rhs.words_[i];
+  return diff == 0;
+}
+
+template<int W>
+bool FixedBitset<W>::IsSubsetOf(const FixedBitset<W>& rhs) const {
+  uint64_t outside = 0;
+  for (int i = 0; i < W; i++) outside |= words_[i] & ~rhs.words_[i];
+  return outside == 0;
+}
+
+template<int W>
+void FixedBitset<W>::Union(const uint64_t* row) {
+  for (int i = 0; i < W; i++) words_[i] |= row[i];
+}
+
+template<int W>
+bool FixedBitset<W>::IsSubsetOf(const uint64_t* row) const {
+  uint64_t outside = 0;
+  for (int i = 0; i < W; i++) outside |= words_[i] & ~row[i];
+  return outside == 0;
+}
+
+template<int W>
+bool FixedBitset<W>::SetIntersection(const uint64_t* a, const FixedBitset<W>& b) {
+  uint64_t any = 0;
+  for (int i = 0; i < W; i++) {
+    words_[i] = a[i] & b.words_[i];
+    any |= words_[i];
+  }
+  return any != 0;
+}
+} // namespace triangulator
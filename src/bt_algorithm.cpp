@@ -1,134 +1,123 @@
 #include "bt_algorithm.hpp"
 
 #include <vector>
-#include <map>
 #include <cassert>
-#include <queue>
+#include <algorithm>
+#include <iterator>
+#include <limits>
 
 #include "graph.hpp"
 #include "id_set.hpp"
+#include "workspace.hpp"
 
 namespace triangulator {
 
-int BtAlgorithm::MergeCost(int c1, int c2) const {
-  return std::max(c1, c2);
+int BtAlgorithmBase::threads_ = 1;
+
+void BtAlgorithmBase::SetThreads(int threads) {
+  assert(threads >= 1);
+  threads_ = threads;
 }
 
-int BtAlgorithm::CliqueCost(const Graph& graph, const std::vector<int>& pmc, const std::vector<int>& parent_sep) const {
-  return pmc.size() - 1;
+BtAlgorithmBase::BtAlgorithmBase(SharedGraph graph)
+  : graph_(graph), dirty_size_(std::numeric_limits<int>::max()), ws_(threads_) {
+  std::vector<int> all_vertices(graph_->n());
+  for (int i = 0; i < graph_->n(); i++) all_vertices[i] = i;
+  root_ = InsertState(std::vector<int>(), all_vertices);
 }
 
-std::pair<int, std::vector<Edge>> BtAlgorithm::Solve(const Graph& graph, const std::vector<std::vector<int> >& pmcs) {
-  std::vector<std::tuple<int, int, int> > triplets;
-  IdSet<std::vector<int> > separators, components;
-  std::vector<int> all_vertices(graph.n());
-  for (int i = 0; i < graph.n(); i++) all_vertices[i] = i;
-  int none_sep_id = separators.Insert({});
-  int all_comp_id = components.Insert(all_vertices);
-  for (int i = 0; i < pmcs.size(); i++) {
-    const auto& pmc = pmcs[i];
-    for (const auto& out_component : graph.Components(pmc)) {
-      std::vector<int> separator = graph.Neighbors(out_component);
-      assert(separator.size() < pmc.size());
-      std::vector<char> in_separator(graph.n());
-      for (int v : separator) in_separator[v] = true;
-      std::vector<int> component;
-      int found = 0;
-      for (int v : pmc) {
-        if (!in_separator[v]) {
-          component = graph.FindComponentAndMark(v, in_separator);
-          found++;
-        }
-      }
-      assert(found == 1);
-      std::sort(separator.begin(), separator.end());
-      std::sort(component.begin(), component.end());
-      int sep_id = separators.Insert(separator);
-      int comp_id = components.Insert(component);
-      triplets.push_back(std::make_tuple(i, sep_id, comp_id));
+int BtAlgorithmBase::InsertState(VertexSpan separator, VertexSpan component) {
+  int comp_id = components_.Insert(component);
+  if (comp_id == (int)separator_of_.size()) {
+    separator_of_.push_back(separators_.Insert(separator));
+    state_size_.push_back(separator.size() + component.size());
+  }
+  return comp_id;
+}
+
+// A component of G - pmc other than C is separated from the inner component of S = N(C) if its own separator is
+// inside S. Otherwise it has a neighbor in pmc \ S, which is connected in G - S, and is a part of the inner component.
+void FindPmcTriplets(const Pmc& pmc, PmcTriplets& triplets) {
+  const auto& outer = pmc.components;
+  triplets.inner.resize(outer.size());
+  triplets.children.resize(outer.size());
+  for (int j = 0; j < (int)outer.size(); j++) {
+    const std::vector<int>& separator = outer[j].first;
+    assert(separator.size() < pmc.vertices.size());
+    triplets.inner[j].first = separator;
+    std::vector<int>& component = triplets.inner[j].second;
+    component.clear();
+    std::set_difference(pmc.vertices.begin(), pmc.vertices.end(), separator.begin(), separator.end(), std::back_inserter(component));
+    triplets.children[j].clear();
+    for (int c = 0; c < (int)outer.size(); c++) {
+      if (c == j || std::includes(separator.begin(), separator.end(), outer[c].first.begin(), outer[c].first.end())) continue;
+      triplets.children[j].push_back(c);
+      component.insert(component.end(), outer[c].second.begin(), outer[c].second.end());
     }
-    triplets.push_back(std::make_tuple(i, none_sep_id, all_comp_id));
+    std::sort(component.begin(), component.end());
   }
-  auto cmp = [&](std::tuple<int, int, int> a, std::tuple<int, int, int> b) {
-    int size_a = separators.Get(std::get<1>(a)).size() + components.Get(std::get<2>(a)).size();
-    int size_b = separators.Get(std::get<1>(b)).size() + components.Get(std::get<2>(b)).size();
-    return size_a < size_b;
-  };
-  std::sort(triplets.begin(), triplets.end(), cmp);
-  std::map<std::pair<int, int>, int> dp, opt_choice;
-  for (const auto& triplet : triplets) {
-    const auto& pmc = pmcs[std::get<0>(triplet)];
-    const auto& separator = separators.Get(std::get<1>(triplet));
-    const auto& component = components.Get(std::get<2>(triplet));
-    int cost  = CliqueCost(graph, pmc, separator);
-    bool child_missing = false;
-    std::vector<char> in_pmc(graph.n());
-    for (int v : pmc) in_pmc[v] = true;
-    for (int v : component) {
-      if (!in_pmc[v]) {
-        auto child_component = graph.FindComponentAndMark(v, in_pmc);
-        auto child_separator = graph.Neighbors(child_component);
-        std::sort(child_component.begin(), child_component.end());
-        std::sort(child_separator.begin(), child_separator.end());
-        std::pair<int, int> child_state = {separators.IdOf(child_separator), components.IdOf(child_component)};
-        if (dp.count(child_state)) {
-          cost = MergeCost(cost, dp[child_state]);
-        } else {
-          child_missing = true;
-          break;
+}
+
+void AddBagFill(const Graph& graph, VertexSpan pmc, VertexSpan parent_sep, std::vector<Edge>& fill_edges) {
+  for (int i = 0; i < (int)pmc.size(); i++) {
+    for (int ii = i+1; ii < (int)pmc.size(); ii++) {
+      int u = pmc[i];
+      int v = pmc[ii];
+      if (!graph.HasEdge(u, v)) {
+        if (!std::binary_search(parent_sep.begin(), parent_sep.end(), u) || !std::binary_search(parent_sep.begin(), parent_sep.end(), v)) {
+          fill_edges.push_back({u, v});
         }
       }
     }
-    if (child_missing) continue;
-    std::pair<int, int> this_state = {std::get<1>(triplet), std::get<2>(triplet)};
-    if (!dp.count(this_state) || cost < dp[this_state]) {
-      dp[this_state] = cost;
-      opt_choice[this_state] = std::get<0>(triplet);
-    }
   }
-  if (!dp.count({none_sep_id, all_comp_id})) return {-1, {}};
-  else {
-    std::vector<Edge> fill_edges;
-    std::queue<std::pair<int, int>> reconstruct;
-    reconstruct.push({none_sep_id, all_comp_id});
-    while (!reconstruct.empty()) {
-      std::pair<int, int> state = reconstruct.front();
-      reconstruct.pop();
-      assert(dp.count(state));
-
-      const auto& pmc = pmcs[opt_choice[state]];
-      const auto& separator = separators.Get(state.first);
-      const auto& component = components.Get(state.second);
+}
 
-      for (int i = 0; i < (int)pmc.size(); i++) {
-        for (int ii = i+1; ii < (int)pmc.size(); ii++) {
-          int u = pmc[i];
-          int v = pmc[ii];
-          if (!graph.HasEdge(u, v)) {
-            if (!std::binary_search(separator.begin(), separator.end(), u) || !std::binary_search(separator.begin(), separator.end(), v)) {
-              fill_edges.push_back({u, v});
-            }
-          }
-        }
-      }
+void BtAlgorithmBase::AddPmcs(const PmcStore& pmcs) {
+  std::vector<Pmc> records(pmcs.Size());
+  ParallelFor(pmcs.Size(), ws_.size(), [&](int i, int thread) {
+    graph_->MakePmc(pmcs[i], ws_[thread], records[i]);
+  });
+  AddPmcs(records);
+}
 
-      std::vector<char> in_pmc(graph.n());
-      for (int v : pmc) in_pmc[v] = true;
-      for (int v : component) {
-        if (!in_pmc[v]) {
-          auto child_component = graph.FindComponentAndMark(v, in_pmc);
-          auto child_separator = graph.Neighbors(child_component);
-          std::sort(child_component.begin(), child_component.end());
-          std::sort(child_separator.begin(), child_separator.end());
-          std::pair<int, int> child_state = {separators.IdOf(child_separator), components.IdOf(child_component)};
-          assert(dp.count(child_state));
-          reconstruct.push(child_state);
-        }
-      }
+// The triplets of the PMCs are found in parallel and interned afterwards
+void BtAlgorithmBase::AddPmcs(const std::vector<Pmc>& pmcs) {
+  std::vector<PmcTriplets> found(pmcs.size());
+  ParallelFor(pmcs.size(), ws_.size(), [&](int i, int) {
+    FindPmcTriplets(pmcs[i], found[i]);
+  });
+  std::vector<Triplet> new_triplets;
+  std::vector<int> outer_ids;
+  for (int i = 0; i < (int)pmcs.size(); i++) {
+    int pmc_id = pmcs_.Size();
+    pmcs_.Add(pmcs[i].vertices);
+    const PmcTriplets& f = found[i];
+    outer_ids.clear();
+    for (const auto& outer : pmcs[i].components) {
+      outer_ids.push_back(InsertState(outer.first, outer.second));
+    }
+    for (int j = 0; j < (int)f.inner.size(); j++) {
+      int begin = children_.size();
+      for (int c : f.children[j]) children_.push_back(outer_ids[c]);
+      new_triplets.push_back({pmc_id, InsertState(f.inner[j].first, f.inner[j].second), begin, (int)children_.size()});
     }
-    return {dp[{none_sep_id, all_comp_id}], fill_edges};
+    int begin = children_.size();
+    children_.insert(children_.end(), outer_ids.begin(), outer_ids.end());
+    new_triplets.push_back({pmc_id, root_, begin, (int)children_.size()});
   }
+  auto cmp = [&](const Triplet& a, const Triplet& b) {
+    if (state_size_[a.state] != state_size_[b.state]) return state_size_[a.state] < state_size_[b.state];
+    return a.state < b.state || (a.state == b.state && a.pmc < b.pmc);
+  };
+  std::sort(new_triplets.begin(), new_triplets.end(), cmp);
+  dirty_.resize(components_.Size());
+  for (const Triplet& triplet : new_triplets) {
+    dirty_[triplet.state] = true;
+    dirty_size_ = std::min(dirty_size_, state_size_[triplet.state]);
+  }
+  int old_size = triplets_.size();
+  triplets_.insert(triplets_.end(), new_triplets.begin(), new_triplets.end());
+  std::inplace_merge(triplets_.begin(), triplets_.begin() + old_size, triplets_.end(), cmp);
 }
 
 } // namespace triangulator
-
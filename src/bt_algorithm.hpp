@@ -1,17 +1,342 @@
 #pragma once
 
-// Implementation of the BT-algorithm. Parameterized by the MergeCost and CliqueCost functions.
+// Implementation of the BT-algorithm. Parameterized by a cost policy giving the CliqueCost and MergeCost functions.
+// The algorithm is incremental: PMCs can be added between calls to Solve, and the triplets and dp values of the
+// earlier PMCs are kept. A pass only revisits the states that the new PMCs can improve.
+// Triplet construction and each layer of the DP, i.e., the triplets with the same |S| + |C|, run on SetThreads threads.
 
 #include <vector>
+#include <limits>
+#include <queue>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <cassert>
 
 #include "graph.hpp"
+#include "id_set.hpp"
+#include "workspace.hpp"
+#include "tree_decomposition.hpp"
+#include "pmc_store.hpp"
 
 namespace triangulator {
-class BtAlgorithm {
+// Interface
+
+// Cost policies. CliqueCost is the cost of a bag that is a PMC attached to its parent by parent_sep and MergeCost
+// combines it with the costs of the subtrees. MergeCost must be monotone for the bounds of Feasible to be sound.
+struct TreewidthCost {
+  typedef int Cost;
+  static Cost CliqueCost(const Graph& graph, VertexSpan pmc, VertexSpan parent_sep);
+  static Cost MergeCost(Cost c1, Cost c2);
+};
+
+// Minimum fill-in. The fill edges of a bag are counted unless both of their endpoints are in the parent separator,
+// in which case they are counted in the parent.
+struct FillInCost {
+  typedef long long Cost;
+  static Cost CliqueCost(const Graph& graph, VertexSpan pmc, VertexSpan parent_sep);
+  static Cost MergeCost(Cost c1, Cost c2);
+};
+
+// Sum over the bags of the product of the domain sizes of their vertices, i.e., the total table size of a junction
+// tree. Saturates at 2^62.
+struct TableSizeCost {
+  typedef long long Cost;
+  static Cost CliqueCost(const Graph& graph, VertexSpan pmc, VertexSpan parent_sep);
+  static Cost MergeCost(Cost c1, Cost c2);
+};
+
+// The largest table size of a bag. Generalizes treewidth to vertices weighted by their domain sizes.
+struct MaxTableSizeCost {
+  typedef long long Cost;
+  static Cost CliqueCost(const Graph& graph, VertexSpan pmc, VertexSpan parent_sep);
+  static Cost MergeCost(Cost c1, Cost c2);
+};
+
+// The triplets of a PMC before interning: for each component of G - pmc, the component on the other side of its
+// separator and the indices of the other components of G - pmc inside it. Found from the components of the record
+// without traversing the graph.
+struct PmcTriplets {
+  std::vector<std::pair<std::vector<int>, std::vector<int> > > inner;
+  std::vector<std::vector<int> > children;
+};
+void FindPmcTriplets(const Pmc& pmc, PmcTriplets& triplets);
+
+// Adds the fill edges of the bag pmc that are not inside the separator to its parent
+void AddBagFill(const Graph& graph, VertexSpan pmc, VertexSpan parent_sep, std::vector<Edge>& fill_edges);
+
+// The part of the algorithm that does not depend on the costs: the states, the triplets and their children
+class BtAlgorithmBase {
 public:
-  std::pair<int, std::vector<Edge> > Solve(const Graph& graph, const std::vector<std::vector<int> >& pmcs);
+  explicit BtAlgorithmBase(SharedGraph graph);
+  void AddPmcs(const std::vector<Pmc>& pmcs);
+  // Finds the components of the PMCs first
+  void AddPmcs(const PmcStore& pmcs);
+
+  static void SetThreads(int threads);
+
+  BtAlgorithmBase(const BtAlgorithmBase&) = delete;
+  BtAlgorithmBase& operator=(const BtAlgorithmBase&) = delete;
+protected:
+  const SharedGraph graph_;
+  PmcStore pmcs_;
+  // A state is a separator S together with a full component C of S. Since S = N(C), the states are identified with
+  // the ids of their components.
+  VertexSetIds separators_, components_;
+  std::vector<int> separator_of_, state_size_;
+  int root_;
+  // The children of a triplet are the components of G - pmc inside the component of state. They are states too and
+  // stored in children_[children_begin, children_end).
+  struct Triplet {
+    int pmc, state, children_begin, children_end;
+  };
+  std::vector<int> children_;
+  // Sorted by |S| + |C|, then by state and then by pmc
+  std::vector<Triplet> triplets_;
+  // The states that got new triplets since the last pass, and the smallest |S| + |C| of them
+  std::vector<char> dirty_;
+  int dirty_size_;
+  // One per thread, for finding the components of the PMCs that are given without them
+  std::vector<TraversalWorkspace> ws_;
+
+  int InsertState(VertexSpan separator, VertexSpan component);
+  // Calls f(i, thread) for each i in 0..n-1, distributing the items dynamically over the threads
+  template<typename F>
+  static void ParallelFor(int n, int threads, const F& f);
 private:
-  int MergeCost(int c1, int c2) const;
-  int CliqueCost(const Graph& graph, const std::vector<int>& pmc, const std::vector<int>& parent_sep) const;
+  static int threads_;
+  // Loops with less work items than this are not worth starting threads for
+  static const int kMinParallelItems = 64;
 };
+
+template<typename CostPolicy>
+class BtAlgorithm : public BtAlgorithmBase {
+public:
+  typedef typename CostPolicy::Cost Cost;
+
+  explicit BtAlgorithm(SharedGraph graph);
+  // Returns the optimal cost and fill edges over the PMCs added so far, or -1 if there is no triangulation with them.
+  // If no PMCs were added after a Feasible whose bound skipped no triplets, only the reconstruction is left to do.
+  std::pair<Cost, std::vector<Edge> > Solve();
+  // Returns whether there is a triangulation of cost at most bound over the PMCs added so far, without reconstructing
+  // it. Triplets whose cost exceeds the bound are skipped, which saves work only if some of the PMCs exceed the bound.
+  bool Feasible(Cost bound);
+  // The tree decomposition of the triangulation returned by the last successful Solve. It has a bag for each PMC of
+  // the triangulation.
+  const TreeDecomposition& Decomposition() const;
+private:
+  std::vector<Cost> dp_;
+  std::vector<Triplet> opt_triplet_;
+  // The states whose dp value decreased in the current pass
+  std::vector<char> changed_;
+  // The dp value of each state is optimal whenever the optimum is at most exact_bound_
+  Cost exact_bound_;
+  TreeDecomposition decomposition_;
+
+  static Cost NotRealized();
+  // Returns the cost of the triplet, or NotRealized() if some of its children are not realized yet or the cost
+  // exceeds the bound. Sets over_bound in the latter case.
+  Cost TripletCost(const Triplet& triplet, Cost bound, bool& over_bound) const;
+  // Runs the DP over the triplets of cost at most bound. The root is the largest state, so it is always processed last.
+  void Pass(Cost bound);
+  // Collects the fill edges and the tree decomposition of the optimal triplets
+  std::vector<Edge> Reconstruct();
+};
+
+
+// Implementation
+inline TreewidthCost::Cost TreewidthCost::CliqueCost(const Graph&, VertexSpan pmc, VertexSpan) {
+  return pmc.size() - 1;
+}
+
+inline TreewidthCost::Cost TreewidthCost::MergeCost(Cost c1, Cost c2) {
+  return std::max(c1, c2);
+}
+
+inline FillInCost::Cost FillInCost::CliqueCost(const Graph& graph, VertexSpan pmc, VertexSpan parent_sep) {
+  Cost fill = 0;
+  for (int i = 0; i < (int)pmc.size(); i++) {
+    bool in_sep = std::binary_search(parent_sep.begin(), parent_sep.end(), pmc[i]);
+    for (int ii = i+1; ii < (int)pmc.size(); ii++) {
+      if (!graph.HasEdge(pmc[i], pmc[ii])) {
+        if (!in_sep || !std::binary_search(parent_sep.begin(), parent_sep.end(), pmc[ii])) fill++;
+      }
+    }
+  }
+  return fill;
+}
+
+inline FillInCost::Cost FillInCost::MergeCost(Cost c1, Cost c2) {
+  return c1 + c2;
+}
+
+inline TableSizeCost::Cost TableSizeCost::CliqueCost(const Graph& graph, VertexSpan pmc, VertexSpan) {
+  const Cost kMax = (Cost)1 << 62;
+  Cost size = 1;
+  for (int v : pmc) {
+    if (size > kMax / graph.DomainSize(v)) return kMax;
+    size *= graph.DomainSize(v);
+  }
+  return size;
+}
+
+inline TableSizeCost::Cost TableSizeCost::MergeCost(Cost c1, Cost c2) {
+  const Cost kMax = (Cost)1 << 62;
+  return (c1 >= kMax - c2) ? kMax : c1 + c2;
+}
+
+inline MaxTableSizeCost::Cost MaxTableSizeCost::CliqueCost(const Graph& graph, VertexSpan pmc, VertexSpan parent_sep) {
+  return TableSizeCost::CliqueCost(graph, pmc, parent_sep);
+}
+
+inline MaxTableSizeCost::Cost MaxTableSizeCost::MergeCost(Cost c1, Cost c2) {
+  return std::max(c1, c2);
+}
+
+template<typename F>
+void BtAlgorithmBase::ParallelFor(int n, int threads, const F& f) {
+  if (threads <= 1 || n < kMinParallelItems) {
+    for (int i = 0; i < n; i++) f(i, 0);
+    return;
+  }
+  std::atomic<int> next(0);
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back([&next, &f, n, t]() {
+      for (int i = next++; i < n; i = next++) f(i, t);
+    });
+  }
+  for (auto& worker : workers) worker.join();
+}
+
+template<typename CostPolicy>
+BtAlgorithm<CostPolicy>::BtAlgorithm(SharedGraph graph) : BtAlgorithmBase(graph), exact_bound_(NotRealized() - 1) { }
+
+template<typename CostPolicy>
+typename BtAlgorithm<CostPolicy>::Cost BtAlgorithm<CostPolicy>::NotRealized() {
+  return std::numeric_limits<Cost>::max();
+}
+
+template<typename CostPolicy>
+typename BtAlgorithm<CostPolicy>::Cost BtAlgorithm<CostPolicy>::TripletCost(const Triplet& triplet, Cost bound, bool& over_bound) const {
+  Cost cost = CostPolicy::CliqueCost(*graph_, pmcs_[triplet.pmc], separators_.Get(separator_of_[triplet.state]));
+  if (cost > bound) {
+    over_bound = true;
+    return NotRealized();
+  }
+  for (int i = triplet.children_begin; i < triplet.children_end; i++) {
+    if (dp_[children_[i]] == NotRealized()) return NotRealized();
+    cost = CostPolicy::MergeCost(cost, dp_[children_[i]]);
+    if (cost > bound) {
+      over_bound = true;
+      return NotRealized();
+    }
+  }
+  return cost;
+}
+
+// The dp values of earlier calls are costs of triangulations that still exist, so they are valid starting values
+// and a single pass over the triplets in order of size makes them optimal for the current PMCs.
+// The children of a state are strictly smaller than it, so the triplets of one layer only read dp values of earlier
+// layers. The triplets of each state are processed by a single thread, which makes the updates race free and the
+// result independent of the number of threads.
+// Skipping triplets over the bound keeps every dp value the cost of an existing triangulation, so the invariant
+// above holds also after bounded passes.
+// A triplet can only improve its state if it is new or a child of it improved in this pass, so the other triplets
+// are skipped and the pass starts from the layer of the smallest dirty state. This needs the skipped triplets to
+// have been evaluated under a bound at least as large, so a bound above exact_bound_ makes a full pass.
+template<typename CostPolicy>
+void BtAlgorithm<CostPolicy>::Pass(Cost bound) {
+  dp_.resize(components_.Size(), NotRealized());
+  opt_triplet_.resize(components_.Size());
+  dirty_.resize(components_.Size());
+  changed_.assign(components_.Size(), false);
+  bool full = bound > exact_bound_;
+  int first = 0;
+  if (!full) {
+    first = std::partition_point(triplets_.begin(), triplets_.end(), [&](const Triplet& triplet) {
+      return state_size_[triplet.state] < dirty_size_;
+    }) - triplets_.begin();
+  }
+  std::atomic<bool> pruned(false);
+  std::vector<int> groups;
+  for (int begin = first; begin < (int)triplets_.size(); ) {
+    int size = state_size_[triplets_[begin].state];
+    groups.clear();
+    int end = begin;
+    for (; end < (int)triplets_.size() && state_size_[triplets_[end].state] == size; end++) {
+      if (end == begin || triplets_[end].state != triplets_[end - 1].state) groups.push_back(end);
+    }
+    groups.push_back(end);
+    ParallelFor(groups.size() - 1, ws_.size(), [&](int group, int) {
+      for (int i = groups[group]; i < groups[group + 1]; i++) {
+        const Triplet& triplet = triplets_[i];
+        bool improves = full || dirty_[triplet.state];
+        for (int j = triplet.children_begin; !improves && j < triplet.children_end; j++) {
+          improves = changed_[children_[j]];
+        }
+        if (!improves) continue;
+        bool over_bound = false;
+        Cost cost = TripletCost(triplet, bound, over_bound);
+        if (over_bound) pruned = true;
+        if (cost < dp_[triplet.state]) {
+          dp_[triplet.state] = cost;
+          opt_triplet_[triplet.state] = triplet;
+          changed_[triplet.state] = true;
+        }
+      }
+    });
+    begin = end;
+  }
+  if (pruned) {
+    exact_bound_ = bound;
+  } else if (full) {
+    exact_bound_ = NotRealized() - 1;
+  }
+  dirty_.assign(components_.Size(), false);
+  dirty_size_ = std::numeric_limits<int>::max();
+}
+
+template<typename CostPolicy>
+std::pair<typename BtAlgorithm<CostPolicy>::Cost, std::vector<Edge> > BtAlgorithm<CostPolicy>::Solve() {
+  Pass(NotRealized() - 1);
+  if (dp_[root_] == NotRealized()) return {-1, {}};
+  return {dp_[root_], Reconstruct()};
+}
+
+template<typename CostPolicy>
+bool BtAlgorithm<CostPolicy>::Feasible(Cost bound) {
+  assert(bound < NotRealized());
+  Pass(bound);
+  return dp_[root_] <= bound;
+}
+
+template<typename CostPolicy>
+const TreeDecomposition& BtAlgorithm<CostPolicy>::Decomposition() const {
+  return decomposition_;
+}
+
+// The queue holds the states together with the bag of their parent triplet
+template<typename CostPolicy>
+std::vector<Edge> BtAlgorithm<CostPolicy>::Reconstruct() {
+  std::vector<Edge> fill_edges;
+  decomposition_ = TreeDecomposition();
+  std::queue<std::pair<int, int> > reconstruct;
+  reconstruct.push({root_, -1});
+  while (!reconstruct.empty()) {
+    int state = reconstruct.front().first;
+    int parent_bag = reconstruct.front().second;
+    reconstruct.pop();
+    assert(dp_[state] != NotRealized());
+    const Triplet& triplet = opt_triplet_[state];
+    AddBagFill(*graph_, pmcs_[triplet.pmc], separators_.Get(separator_of_[state]), fill_edges);
+    int bag = decomposition_.AddBag(pmcs_[triplet.pmc].ToVector());
+    if (parent_bag != -1) decomposition_.AddEdge(parent_bag, bag);
+    for (int i = triplet.children_begin; i < triplet.children_end; i++) {
+      assert(dp_[children_[i]] != NotRealized());
+      reconstruct.push({children_[i], bag});
+    }
+  }
+  return fill_edges;
+}
 } // namespace triangulator
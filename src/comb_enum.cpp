@@ -7,105 +7,59 @@
 #include "graph.hpp"
 #include "mcs.hpp"
 #include "utils.hpp"
+#include "workspace.hpp"
+#include "pmc_store.hpp"
 
 namespace triangulator {
 namespace comb_enumerator {
 namespace {
 
-void dfs2(const Graph& graph, int x, std::vector<int>& u) {
-  assert(u[x] == 0);
-  u[x] = 1;
-  for (int nx : graph.Neighbors(x)) {
-    if (u[nx] == 0) dfs2(graph, nx, u);
-    else if (u[nx] == 2) {
-      u[nx] = 3;
-    }
-  }
-}
-
-bool extend2(const Graph& graph, const std::vector<int>& pmc, int x) {
-  std::vector<int> u(graph.n());
-  for (int v : pmc) u[v] = 2;
-  dfs2(graph, x, u);
-  for (int v : pmc) {
-    if (u[v] != 3) return false;
-  }
-  return true;
-}
-
-int dfs1(const Graph& graph, int x, std::vector<int>& u, int it) {
-  assert(u[x] == 0);
-  u[x] = 1;
-  int r = 0;
-  for (int nx : graph.Neighbors(x)) {
-    if (u[nx] == 0) r += dfs1(graph, nx, u, it);
-    else if (u[nx] > 1 && u[nx] < it) {
-      u[nx] = it;
-      r++;
-    }
-  }
-  return r;
+bool extend2(const Graph& graph, VertexSpan pmc, int x, TraversalWorkspace& ws) {
+  ws.blocked.Clear(graph.n());
+  for (int v : pmc) ws.blocked.Set(v);
+  graph.FindComponentAndMark(x, ws);
+  return ws.neighbors.size() == pmc.size();
 }
 
-bool HasFullComponent(const Graph& graph, const std::vector<int>& sep) {
-  std::vector<int> u(graph.n());
-  int it = 2;
+bool HasFullComponent(const Graph& graph, VertexSpan sep, TraversalWorkspace& ws) {
+  ws.blocked.Clear(graph.n());
   for (int x : sep) {
-    u[x] = it;
+    ws.blocked.Set(x);
   }
   for (int i = 0; i < graph.n(); i++) {
-    if (u[i] == 0) {
-      it++;
-      int c = dfs1(graph, i, u, it);
-      assert(c <= (int)sep.size());
-      if (c == (int)sep.size()) return true;
+    if (!ws.blocked.Has(i)) {
+      graph.FindComponentAndMark(i, ws);
+      assert(ws.neighbors.size() <= sep.size());
+      if (ws.neighbors.size() == sep.size()) return true;
     }
   }
   return false;
 }
 
-bool IsPmc(const Graph& graph, const std::vector<int>& pmc) {
-  if (HasFullComponent(graph, pmc)) return false;
-  std::vector<int> u(graph.n());
-  for (int x : pmc) {
-    std::fill(u.begin(), u.end(), 0);
-    for (int y : pmc) {
-      if (y != x) {
-        u[y] = 2;
-      }
-    }
-    dfs2(graph, x, u);
-    for (int y : pmc) {
-      if (y != x) {
-        if (u[y] != 3) return false;
-      }
-    }
-  }
-  return true;
-}
-
-std::vector<std::vector<int>> OneMoreVertex(const Graph& new_graph, const std::vector<std::vector<int>>& pmcs, 
-  const std::vector<std::vector<int>>& minseps, const std::vector<std::vector<int>>& new_minseps, int x) {
-  std::vector<std::vector<int>> new_pmcs;
-  for (const auto& pmc : pmcs) {
-    if (!HasFullComponent(new_graph, pmc)) {
-      new_pmcs.push_back(pmc);
+PmcStore OneMoreVertex(const Graph& new_graph, const PmcStore& pmcs,
+  const std::vector<std::vector<int>>& minseps, const std::vector<std::vector<int>>& new_minseps, int x, TraversalWorkspace& ws) {
+  PmcStore new_pmcs;
+  for (int i = 0; i < pmcs.Size(); i++) {
+    VertexSpan pmc = pmcs[i];
+    if (!HasFullComponent(new_graph, pmc, ws)) {
+      new_pmcs.Add(pmc);
     } else {
-      if (extend2(new_graph, pmc, x)) {
-        new_pmcs.push_back(pmc);
-        new_pmcs.back().push_back(x);
+      if (extend2(new_graph, pmc, x, ws)) {
+        new_pmcs.Add(pmc);
+        new_pmcs.AddVertex(x);
       }
     }
   }
   int i2 = 0;
   std::set<std::vector<int>> tried;
+  ComponentLabels labels;
   for (const auto& minsep : new_minseps) {
     if (std::find(minsep.begin(), minsep.end(), x) != minsep.end()) continue;
-    if (extend2(new_graph, minsep, x)) {
-      new_pmcs.push_back(minsep);
-      new_pmcs.back().push_back(x);
-      if (HasFullComponent(new_graph, new_pmcs.back())) {
-        new_pmcs.pop_back();
+    if (extend2(new_graph, minsep, x, ws)) {
+      new_pmcs.Add(minsep);
+      new_pmcs.AddVertex(x);
+      if (HasFullComponent(new_graph, new_pmcs[new_pmcs.Size() - 1], ws)) {
+        new_pmcs.RemoveLast();
       }
     }
     while (i2 < (int)minseps.size() && minseps[i2] < minsep) i2++;
@@ -127,8 +81,8 @@ std::vector<std::vector<int>> OneMoreVertex(const Graph& new_graph, const std::v
           std::sort(npmc.begin(), npmc.end());
           if (tried.count(npmc)) continue;
           tried.insert(npmc);
-          if (IsPmc(new_graph, npmc)) {
-            new_pmcs.push_back(npmc);
+          if (new_graph.IsPmc(npmc, labels)) {
+            new_pmcs.Add(npmc);
           }
         }
       }
@@ -142,18 +96,19 @@ std::vector<std::vector<int>> OneMoreVertex(const Graph& new_graph, const std::v
 std::vector<std::vector<int>> FindMinSeps(const Graph& graph, int ub) {
   std::vector<std::vector<int>> minseps;
   std::set<std::vector<int>> ff;
-  std::vector<int> u(graph.n());
+  TraversalWorkspace ws;
   for (int i = 0; i < graph.n(); i++) {
     if (graph.Neighbors(i).empty()) continue;
-    auto block = graph.Neighbors(i);
-    block.push_back(i);
-    auto cs = graph.Components(block);
-    for (const auto& c : cs) {
-      auto nbs = graph.Neighbors(c);
-      std::sort(nbs.begin(), nbs.end());
-      if (!ff.count(nbs)) {
-        ff.insert(nbs);
-        minseps.push_back(nbs);
+    ws.blocked.Clear(graph.n());
+    ws.blocked.Set(i);
+    for (int v : graph.Neighbors(i)) ws.blocked.Set(v);
+    for (int v = 0; v < graph.n(); v++) {
+      if (ws.blocked.Has(v)) continue;
+      graph.FindComponentAndMark(v, ws);
+      std::sort(ws.neighbors.begin(), ws.neighbors.end());
+      if (!ff.count(ws.neighbors)) {
+        ff.insert(ws.neighbors);
+        minseps.push_back(ws.neighbors);
       }
     }
   }
@@ -161,17 +116,16 @@ std::vector<std::vector<int>> FindMinSeps(const Graph& graph, int ub) {
     if (ub != -1 && (int)minseps.size() >= ub) break;
     auto minsep = minseps[i];
     for (int x : minsep) {
-      std::vector<int> block;
-      block.reserve(minsep.size() + graph.Neighbors(x).size());
-      for (int v : minsep) block.push_back(v);
-      for (int v : graph.Neighbors(x)) block.push_back(v);
-      auto cs = graph.Components(block);
-      for (const auto& c : cs) {
-        auto nbs = graph.Neighbors(c);
-        std::sort(nbs.begin(), nbs.end());
-        if (!ff.count(nbs)) {
-          ff.insert(nbs);
-          minseps.push_back(nbs);
+      ws.blocked.Clear(graph.n());
+      for (int v : minsep) ws.blocked.Set(v);
+      for (int v : graph.Neighbors(x)) ws.blocked.Set(v);
+      for (int v = 0; v < graph.n(); v++) {
+        if (ws.blocked.Has(v)) continue;
+        graph.FindComponentAndMark(v, ws);
+        std::sort(ws.neighbors.begin(), ws.neighbors.end());
+        if (!ff.count(ws.neighbors)) {
+          ff.insert(ws.neighbors);
+          minseps.push_back(ws.neighbors);
         }
       }
     }
@@ -180,8 +134,8 @@ std::vector<std::vector<int>> FindMinSeps(const Graph& graph, int ub) {
   return minseps;
 }
 
-std::vector<std::vector<int>> Pmcs(const Graph& graph) {
-  if (graph.n() == 0) return {};
+PmcStore Pmcs(const Graph& graph) {
+  if (graph.n() == 0) return PmcStore();
   assert(graph.IsConnectedOrIsolated());
   std::vector<int> order = mcs::Mcs(graph);
   std::reverse(order.begin(), order.end());
@@ -190,8 +144,10 @@ std::vector<std::vector<int>> Pmcs(const Graph& graph) {
     ord[order[i]] = i;
   }
   Graph new_graph(graph.n());
-  std::vector<std::vector<int>> pmcs = {{order[0]}};
+  PmcStore pmcs;
+  pmcs.Add(std::vector<int>{order[0]});
   std::vector<std::vector<int>> minseps = {};
+  TraversalWorkspace ws;
   for (int i = 1; i < graph.n(); i++) {
     int x = order[i];
     for (int nx : graph.Neighbors(x)) {
@@ -201,12 +157,9 @@ std::vector<std::vector<int>> Pmcs(const Graph& graph) {
     }
     assert(new_graph.IsConnectedOrIsolated());
     auto new_minseps = FindMinSeps(new_graph, -1);
-    pmcs = OneMoreVertex(new_graph, pmcs, minseps, new_minseps, x);
+    pmcs = OneMoreVertex(new_graph, pmcs, minseps, new_minseps, x, ws);
     minseps = new_minseps;
-    for (auto& pmc : pmcs) {
-      std::sort(pmc.begin(), pmc.end());
-    }
-    utils::SortAndDedup(pmcs);
+    pmcs.SortAndDedup();
   }
   return pmcs;
 }
@@ -3,10 +3,11 @@
 #include <vector>
 
 #include "graph.hpp"
+#include "pmc_store.hpp"
 
 namespace triangulator {
 namespace comb_enumerator {
-std::vector<std::vector<int>> Pmcs(const Graph& graph);
+PmcStore Pmcs(const Graph& graph);
 std::vector<std::vector<int>> FindMinSeps(const Graph& graph, int ub);
 } // namespace comb_enumerator
 } // namespace triangulator
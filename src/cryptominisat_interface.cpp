@@ -43,6 +43,21 @@ bool CryptominisatInterface::SolutionValue(Lit lit) {
   }
   num_clauses_++;
 }
+void CryptominisatInterface::GetModel(const Lit* lits, int num_lits, Bitset& values) {
+  values.Resize(num_lits);
+  const std::vector<CMSat::lbool>& model = solver_.get_model();
+  for (int i = 0; i < num_lits; i++) {
+    if (!lits[i].IsDef() || lits[i].IsFalse()) continue;
+    if (lits[i].IsTrue()) {
+      values.Set(i);
+      continue;
+    }
+    int lit_value = LitValue(lits[i]);
+    assert(abs(lit_value) <= num_vars_);
+    bool solution_value = (model[abs(lit_value) - 1] == CMSat::l_True);
+    if (solution_value == (lit_value > 0)) values.Set(i);
+  }
+}
 void CryptominisatInterface::FreezeVar(Lit var) {
   
 }
@@ -11,6 +11,7 @@ public:
   Lit NewVar() override;
   void AddClause(std::vector<Lit> clause) override;
   bool SolutionValue(Lit lit) override;
+  void GetModel(const Lit* lits, int num_lits, Bitset& values) override;
   bool Solve(std::vector<Lit> assumptions, bool allow_simp) override;
   void FreezeVar(Lit var) final;
   CryptominisatInterface();
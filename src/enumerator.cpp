@@ -1,217 +1,433 @@
 #include "enumerator.hpp"
 
 #include <vector>
-#include <map>
 #include <memory>
 #include <cassert>
 #include <algorithm>
 #include <random>
+#include <set>
 
 #include "sat_interface.hpp"
 #include "graph.hpp"
 #include "utils.hpp"
+#include "comb_enum.hpp"
 
 namespace triangulator{
 // TODO: helpconstraints
 
 void Enumerator::BuildBasicEncoding() {
   // Selection variables
-  for (int i = 0; i < graph_.n(); i++) {
+  for (int i = 0; i < graph_->n(); i++) {
     x_var_[i] = solver_->NewVar();
     solver_->FreezeVar(x_var_[i]);
   }
+  // The lazy encoding adds the rest in RefineLazy
+  if (minsep_encoding_ == 6) return;
   // Connectivity variables
-  for (int i = 0; i < graph_.n(); i++) {
-    for (int ii = 0; ii < graph_.n(); ii++) {
-      if (i == ii) continue;
-      if (i < ii) {
-        if (graph_.HasEdge(i, ii)) c_var_[i][ii] = Lit::TrueLit();
-        else c_var_[i][ii] = solver_->NewVar();
-      }
-      else {
-        assert(c_var_[ii][i].IsDef());
-        c_var_[i][ii] = c_var_[ii][i];
-      }
+  for (int i = 0; i < graph_->n(); i++) {
+    for (int ii = i + 1; ii < graph_->n(); ii++) {
+      ConnectivityVar(i, ii);
     }
   }
   // Basic connectivity implications
-  for (int i = 0; i < graph_.n(); i++) {
-    for (int ii = 0; ii < graph_.n(); ii++) {
-      if (i == ii) continue;
-      for (int iii : graph_.Neighbors(ii)) {
-        if (iii != i) solver_->AddClause({-c_var_[i][ii], x_var_[ii], c_var_[i][iii]});
-      }
-    }
+  for (int i = 0; i < graph_->n(); i++) {
+    AddConnectivityImplications(i);
   }
   // Check that pmc will become a clique
-  for (int i = 0; i < graph_.n(); i++) {
-    for (int ii = i + 1; ii < graph_.n(); ii++) {
+  for (int i = 0; i < graph_->n(); i++) {
+    for (int ii = i + 1; ii < graph_->n(); ii++) {
       solver_->AddClause({-x_var_[i], -x_var_[ii], c_var_[i][ii]});
     }
   }
   // Check that there is no full component
-  for (int i = 0; i < graph_.n(); i++) {
-    std::vector<Lit> new_clause = {x_var_[i]};
-    for (int ii = 0; ii < graph_.n(); ii++) {
-      if (i == ii) continue;
-      Lit new_var = solver_->NewVar();
-      solver_->AddClause({x_var_[ii], -new_var});
-      solver_->AddClause({-c_var_[i][ii], -new_var});
-      if (minsep_encoding_ == 5) {
-        solver_->AddClause({-x_var_[ii], c_var_[i][ii], new_var});
-      }
+  for (int i = 0; i < graph_->n(); i++) {
+    AddNoFullComponent(i);
+  }
+}
+
+Lit Enumerator::ConnectivityVar(int v, int u) {
+  assert(v != u);
+  if (!c_var_[v][u].IsDef()) {
+    if (graph_->HasEdge(v, u)) {
+      c_var_[v][u] = Lit::TrueLit();
+    } else {
+      c_var_[v][u] = solver_->NewVar();
+      // Blocking clauses on the connectivity variables are added between calls, so they cannot be eliminated
+      solver_->FreezeVar(c_var_[v][u]);
+    }
+    c_var_[u][v] = c_var_[v][u];
+  }
+  return c_var_[v][u];
+}
 
-      new_clause.push_back(new_var);
+// Everything reachable from v through unselected vertices is connected to v
+void Enumerator::AddConnectivityImplications(int v) {
+  for (int ii = 0; ii < graph_->n(); ii++) {
+    if (v == ii) continue;
+    for (int iii : graph_->Neighbors(ii)) {
+      if (iii != v) solver_->AddClause({-ConnectivityVar(v, ii), x_var_[ii], ConnectivityVar(v, iii)});
     }
-    solver_->AddClause(new_clause);
-  }  
+  }
 }
 
+// If v is not selected, some selected vertex is not connected to it
+void Enumerator::AddNoFullComponent(int v) {
+  std::vector<Lit> new_clause = {x_var_[v]};
+  for (int ii = 0; ii < graph_->n(); ii++) {
+    if (v == ii) continue;
+    Lit new_var = solver_->NewVar();
+    solver_->AddClause({x_var_[ii], -new_var});
+    solver_->AddClause({-ConnectivityVar(v, ii), -new_var});
+    if (minsep_encoding_ == 5) {
+      solver_->AddClause({-x_var_[ii], ConnectivityVar(v, ii), new_var});
+    }
+    new_clause.push_back(new_var);
+  }
+  solver_->AddClause(new_clause);
+}
+
+// Layer j says which pairs are connected by a path of at most j edges. Only two layers are kept in memory at a
+// time, so building the encoding takes O(n^2) memory besides the clauses.
 void Enumerator::BuildPathLengthEncoding() {
-  std::vector<Matrix<Lit>> cl_var(graph_.n(), Matrix<Lit>(graph_.n(), graph_.n()));
-  std::vector<Matrix<Lit>> f_var(graph_.n(), Matrix<Lit>(graph_.n(), graph_.n()));
-  for (int j = 1; j < graph_.n(); j++) {
-    for (int i = 0; i < graph_.n(); i++) {
-      for (int ii = 0; ii < graph_.n(); ii++) {
+  Matrix<Lit> prev_cl(graph_->n(), graph_->n()), prev_f(graph_->n(), graph_->n());
+  Matrix<Lit> cl(graph_->n(), graph_->n()), f(graph_->n(), graph_->n());
+  for (int j = 1; j < graph_->n(); j++) {
+    for (int i = 0; i < graph_->n(); i++) {
+      for (int ii = 0; ii < graph_->n(); ii++) {
         if (i == ii) continue;
         if (i < ii) {
-          if (graph_.HasEdge(i, ii)) {
-            cl_var[j][i][ii] = Lit::TrueLit();
+          if (graph_->HasEdge(i, ii)) {
+            cl[i][ii] = Lit::TrueLit();
           } else if (j == 1) {
-            cl_var[j][i][ii] = Lit::FalseLit();
+            cl[i][ii] = Lit::FalseLit();
           } else {
-            cl_var[j][i][ii] = solver_->NewVar();
+            cl[i][ii] = solver_->NewVar();
           }
         }
         else {
-          assert(cl_var[j][ii][i].IsDef());
-          cl_var[j][i][ii] = cl_var[j][ii][i];
+          assert(cl[ii][i].IsDef());
+          cl[i][ii] = cl[ii][i];
         }
-        f_var[j][i][ii] = solver_->NewVar();
-        solver_->AddClause({-f_var[j][i][ii], cl_var[j][i][ii]});
-        solver_->AddClause({-f_var[j][i][ii], -x_var_[ii]});
+        f[i][ii] = solver_->NewVar();
+        solver_->AddClause({-f[i][ii], cl[i][ii]});
+        solver_->AddClause({-f[i][ii], -x_var_[ii]});
       }
     }
-  }
-  for (int j = 1; j + 1 < graph_.n(); j++) {
-    for (int i = 0; i < graph_.n(); i++) {
-      for (int ii = 0; ii < graph_.n(); ii++) {
-        if (i == ii) continue;
-        if (i < ii) {
-          solver_->AddClause({-cl_var[j][i][ii], cl_var[j+1][i][ii]});
+    if (j >= 2) {
+      for (int i = 0; i < graph_->n(); i++) {
+        for (int ii = 0; ii < graph_->n(); ii++) {
+          if (i == ii) continue;
+          if (i < ii) {
+            solver_->AddClause({-prev_cl[i][ii], cl[i][ii]});
+          }
+          solver_->AddClause({-prev_f[i][ii], f[i][ii]});
+        }
+      }
+      for (int i = 0; i < graph_->n(); i++) {
+        for (int ii = 0; ii < graph_->n(); ii++) {
+          if (i == ii) continue;
+          if (graph_->HasEdge(i, ii)) continue;
+          std::vector<Lit> new_clause = {-cl[i][ii]};
+          for (int iii : graph_->Neighbors(ii)) {
+            if (iii == i) continue;
+            new_clause.push_back({prev_f[i][iii]});
+          }
+          solver_->AddClause(new_clause);
         }
-        solver_->AddClause({-f_var[j][i][ii], f_var[j+1][i][ii]});
       }
     }
+    std::swap(prev_cl, cl);
+    std::swap(prev_f, f);
   }
-  for (int j = 2; j < graph_.n(); j++) {
-    for (int i = 0; i < graph_.n(); i++) {
-      for (int ii = 0; ii < graph_.n(); ii++) {
-        if (i == ii) continue;
-        if (graph_.HasEdge(i, ii)) continue;
-        std::vector<Lit> new_clause = {-cl_var[j][i][ii]};
-        for (int iii : graph_.Neighbors(ii)) {
-          if (iii == i) continue;
-          new_clause.push_back({f_var[j-1][i][iii]});
-        }
-        solver_->AddClause(new_clause);
+  for (int i = 0; i < graph_->n(); i++) {
+    for (int ii = i + 1; ii < graph_->n(); ii++) {
+      solver_->AddClause({-c_var_[i][ii], prev_cl[i][ii]});
+    }
+  }
+}
+
+// The path-length encoding with the layers replaced by distances in binary. For each source i, a vertex ii is
+// connected to i only if it is adjacent to i or has an unselected neighbor w that is connected to i and closer to it.
+// The distances rule out cyclic support, so the connectivity is exact as in 4, with O(n^2 * deg * log n) clauses
+// instead of O(n^3 * deg).
+void Enumerator::BuildDistanceEncoding() {
+  int bits = 1;
+  while ((1 << bits) < graph_->n()) bits++;
+  std::vector<std::vector<Lit> > distance(graph_->n(), std::vector<Lit>(bits));
+  for (int i = 0; i < graph_->n(); i++) {
+    for (int ii = 0; ii < graph_->n(); ii++) {
+      if (i == ii) continue;
+      // The neighbors of i are at distance 0, which breaks the symmetries between the distances
+      bool adjacent = graph_->HasEdge(i, ii);
+      for (int b = 0; b < bits; b++) distance[ii][b] = adjacent ? Lit::FalseLit() : solver_->NewVar();
+    }
+    for (int ii = 0; ii < graph_->n(); ii++) {
+      if (i == ii || graph_->HasEdge(i, ii)) continue;
+      std::vector<Lit> support = {-c_var_[i][ii]};
+      for (int w : graph_->Neighbors(ii)) {
+        assert(w != i);
+        Lit via = solver_->NewVar();
+        solver_->AddClause({-via, c_var_[i][w]});
+        solver_->AddClause({-via, -x_var_[w]});
+        AddLessThan(via, distance[w], distance[ii]);
+        support.push_back(via);
       }
+      solver_->AddClause(support);
     }
   }
-  for (int i = 0; i < graph_.n(); i++) {
-    for (int ii = i + 1; ii < graph_.n(); ii++) {
-      solver_->AddClause({-c_var_[i][ii], cl_var[graph_.n()-1][i][ii]});
+}
+
+// Adds condition -> (a < b) for the numbers a and b given by their bits, the least significant first. Some bit k is
+// 0 in a and 1 in b and the bits above it are equal, which equal[k] says.
+void Enumerator::AddLessThan(Lit condition, const std::vector<Lit>& a, const std::vector<Lit>& b) {
+  int bits = a.size();
+  assert((int)b.size() == bits);
+  std::vector<Lit> choice = {-condition};
+  Lit equal_above = Lit::TrueLit();
+  for (int k = bits - 1; k >= 0; k--) {
+    Lit pick = solver_->NewVar();
+    solver_->AddClause({-pick, -a[k]});
+    solver_->AddClause({-pick, b[k]});
+    solver_->AddClause({-pick, equal_above});
+    choice.push_back(pick);
+    if (k > 0) {
+      Lit equal = solver_->NewVar();
+      solver_->AddClause({-equal, equal_above});
+      solver_->AddClause({-equal, -a[k], b[k]});
+      solver_->AddClause({-equal, a[k], -b[k]});
+      equal_above = equal;
     }
   }
+  solver_->AddClause(choice);
 }
 
-Enumerator::Enumerator(const Graph& graph, std::shared_ptr<SatInterface> solver, int minsep_encoding)
-  : x_var_(graph.n()), c_var_(graph.n(), graph.n()), solver_(solver), graph_(graph), minsep_encoding_(minsep_encoding) {
+Enumerator::Enumerator(SharedGraph graph, std::shared_ptr<SatInterface> solver, int minsep_encoding)
+  : x_var_(graph->n()), c_var_(graph->n(), graph->n()), solver_(solver), graph_(graph), minsep_encoding_(minsep_encoding) {
+  if (minsep_encoding_ == 6) {
+    lazy_row_.assign(graph->n(), false);
+    lazy_pair_.Resize(graph->n(), graph->n());
+  }
   BuildBasicEncoding();
   if (minsep_encoding_ == 4) {
     BuildPathLengthEncoding();
+  } else if (minsep_encoding_ == 8) {
+    BuildDistanceEncoding();
   }
+  // The connectivity of 4 and 8 is exact, so they never need minseps. The lazy 6 would have to create the
+  // connectivity variables of the seeds before any candidate needs them, without the implications that constrain them.
+  if (seed_minseps_ > 0 && minsep_encoding_ != 4 && minsep_encoding_ != 6 && minsep_encoding_ != 8) {
+    SeedMinseps();
+  }
+}
+
+int Enumerator::seed_minseps_ = 0;
+bool Enumerator::multiple_minseps_ = false;
+
+void Enumerator::SetSeedMinseps(int seed_minseps) {
+  assert(seed_minseps >= 0);
+  seed_minseps_ = seed_minseps;
+}
+
+void Enumerator::SetMultipleMinseps(bool multiple_minseps) {
+  multiple_minseps_ = multiple_minseps;
 }
 
-bool Enumerator::IsBadSep(const std::vector<int>& separator, const Matrix<char>& solution_c_value) const {
-  auto connectedmatrix = graph_.ConnectedMatrix(separator);
-  for (int i = 0; i < graph_.n(); i++) {
-    for (int ii = 0; ii < graph_.n(); ii++) {
-      if (i != ii && solution_c_value[i][ii] && !connectedmatrix[i][ii]) return true;
+// The separator is bad if the solution says that two vertices are connected but they are not connected wrt. the separator.
+// Two vertices are connected wrt. separator if there exists a path between them where all intermediate vertices are outside of the separator,
+// i.e., they are adjacent or both in the closed neighborhood of the same component.
+bool Enumerator::IsBadSep(const std::vector<int>& separator, const std::vector<Bitset>& solution_c_value) {
+  graph_->LabelComponents(separator, labels_);
+  int components = labels_.NumComponents();
+  if ((int)closure_.size() < components) closure_.resize(components);
+  for (int c = 0; c < components; c++) {
+    closure_[c].Resize(graph_->n());
+    for (int v : labels_.Neighbors(c)) closure_[c].Set(v);
+  }
+  for (int i = 0; i < graph_->n(); i++) {
+    if (labels_.Label(i) >= 0) closure_[labels_.Label(i)].Set(i);
+  }
+  for (int i = 0; i < graph_->n(); i++) {
+    if (labels_.Label(i) >= 0 && !solution_c_value[i].IsSubsetOf(closure_[labels_.Label(i)])) return true;
+  }
+  allowed_.Resize(graph_->n());
+  component_mark_.assign(components, -1);
+  for (int v : separator) {
+    allowed_.Clear();
+    for (int nv : graph_->Neighbors(v)) {
+      int c = labels_.Label(nv);
+      if (c == -1) {
+        allowed_.Set(nv);
+      } else if (component_mark_[c] != v) {
+        component_mark_[c] = v;
+        allowed_ |= closure_[c];
+      }
     }
+    allowed_.Set(v);
+    if (!solution_c_value[v].IsSubsetOf(allowed_)) return true;
   }
   return false;
 }
 
+int Enumerator::FindRoot(int v) {
+  int root = v;
+  while (uf_parent_[root] != root) root = uf_parent_[root];
+  while (uf_parent_[v] != root) {
+    int next = uf_parent_[v];
+    uf_parent_[v] = root;
+    v = next;
+  }
+  return root;
+}
+
+// Removing vertices from a separator only makes more pairs connected wrt. it, so dropping each vertex once in order
+// gives the same minsep as retrying IsBadSep after every removal. Removing v merges v and the components adjacent to
+// it into a single component whose closed neighborhood is the union of theirs and N[v]. The other components stay
+// the same, so a pair that is broken stays broken unless both of its vertices are in the new closed neighborhood.
+// Only the pairs that are still broken are kept, and the separator is bad as long as some of them remain.
+std::vector<int> Enumerator::MinimizeSeparator(const std::vector<int>& separator, const std::vector<Bitset>& solution_c_value) {
+  int n = graph_->n();
+  graph_->LabelComponents(separator, labels_);
+  uf_parent_.resize(n);
+  if ((int)root_closure_.size() < n) root_closure_.resize(n);
+  std::vector<int> representative(labels_.NumComponents(), -1);
+  for (int v = 0; v < n; v++) {
+    int c = labels_.Label(v);
+    if (c >= 0 && representative[c] == -1) {
+      representative[c] = v;
+      root_closure_[v].Resize(n);
+      for (int u : labels_.Neighbors(c)) root_closure_[v].Set(u);
+    }
+    uf_parent_[v] = (c >= 0 ? representative[c] : v);
+    if (c >= 0) root_closure_[uf_parent_[v]].Set(v);
+  }
+  component_mark_.assign(n, -1);
+  in_separator_.assign(n, false);
+  for (int v : separator) in_separator_[v] = true;
+  merged_.Resize(n);
+  broken_pairs_.clear();
+  for (int v = 0; v < n; v++) {
+    if (labels_.Label(v) >= 0) {
+      merged_ = root_closure_[uf_parent_[v]];
+    } else {
+      merged_.Clear();
+      merged_.Set(v);
+      for (int nv : graph_->Neighbors(v)) {
+        merged_.Set(nv);
+        if (labels_.Label(nv) >= 0) merged_ |= root_closure_[uf_parent_[nv]];
+      }
+    }
+    // Connectivity wrt. a separator is symmetric, so a pair set in both directions is only kept once
+    for (int u = solution_c_value[v].First(); u != -1; u = solution_c_value[v].Next(u)) {
+      if (!merged_.Has(u) && (v < u || !solution_c_value[u].Has(v))) broken_pairs_.push_back({v, u});
+    }
+  }
+  assert(!broken_pairs_.empty());
+  std::vector<int> minsep;
+  for (int v : separator) {
+    merged_.Clear();
+    merged_.Set(v);
+    merged_roots_.clear();
+    for (int nv : graph_->Neighbors(v)) {
+      merged_.Set(nv);
+      if (in_separator_[nv]) continue;
+      int root = FindRoot(nv);
+      if (component_mark_[root] != v) {
+        component_mark_[root] = v;
+        merged_roots_.push_back(root);
+        merged_ |= root_closure_[root];
+      }
+    }
+    // Move the pairs that stay broken to the front, keeping the rest in case v has to stay
+    int still_broken = 0;
+    for (int i = 0; i < broken_pairs_.size(); i++) {
+      if (!merged_.Has(broken_pairs_[i].first) || !merged_.Has(broken_pairs_[i].second)) {
+        std::swap(broken_pairs_[i], broken_pairs_[still_broken++]);
+      }
+    }
+    if (still_broken == 0) {
+      minsep.push_back(v);
+      continue;
+    }
+    broken_pairs_.resize(still_broken);
+    in_separator_[v] = false;
+    for (int root : merged_roots_) uf_parent_[root] = v;
+    std::swap(root_closure_[v], merged_);
+    merged_.Resize(n);
+  }
+  return minsep;
+}
+
 void Enumerator::BlockBadSolution(std::vector<int> solution) {
   std::sort(solution.begin(), solution.end());
   std::vector<int> minsep = solution;
   Log::Write(30, "Minimizing sep of size ", minsep.size());
-  Matrix<char> solution_c_value(graph_.n(), graph_.n());
-  for (int i = 0; i < graph_.n(); i++) {
-    for (int ii = 0; ii < graph_.n(); ii++) {
-      if (i != ii) solution_c_value[i][ii] = solver_->SolutionValue(c_var_[i][ii]);
-    }
+  std::vector<Bitset> solution_c_value(graph_->n(), Bitset(graph_->n()));
+  for (int i = 0; i < graph_->n(); i++) {
+    // The lazy encoding has no variables for the pairs that have not been needed, and GetModel reads them as
+    // unconnected. In the other encodings every pair has a variable.
+    for (int ii = 0; ii < graph_->n(); ii++) assert(ii == i || minsep_encoding_ == 6 || c_var_[i][ii].IsDef());
+    solver_->GetModel(c_var_[i], graph_->n(), solution_c_value[i]);
+    solution_c_value[i].Reset(i);
   }
   assert(IsBadSep(minsep, solution_c_value));
-  for (int i = 0; i < minsep.size(); i++) {
-    std::vector<int> new_minsep;
-    for (int ii = 0; ii < minsep.size(); ii++) {
-      if (ii != i) new_minsep.push_back(minsep[ii]);
-    }
-    if (IsBadSep(new_minsep, solution_c_value)) {
-      minsep = new_minsep;
-      i--;
+  minsep = MinimizeSeparator(minsep, solution_c_value);
+  assert(IsBadSep(minsep, solution_c_value));
+  Log::Write(20, "Found minsep of size ", minsep.size());
+  BlockMinsep(minsep, solution_c_value, solution);
+  if (multiple_minseps_) BlockBrokenPairMinseps(solution, solution_c_value, minsep);
+}
+
+// The connectivity of each pair of components of G - solution that the solution breaks is cut by the minsep N(C)
+// where C is the component of G - N(B) of one side and B is the other side. Different pairs often give different
+// minseps, and blocking them all at once saves the SAT calls that would find them one bad solution at a time.
+void Enumerator::BlockBrokenPairMinseps(const std::vector<int>& solution, const std::vector<Bitset>& solution_c_value, const std::vector<int>& minsep) {
+  graph_->LabelComponents(solution, labels_);
+  Matrix<char> pair_done(labels_.NumComponents(), labels_.NumComponents());
+  std::vector<std::pair<int, std::vector<int> > > sides;
+  for (int v = 0; v < graph_->n(); v++) {
+    int a = labels_.Label(v);
+    if (a < 0) continue;
+    for (int u = v + 1; u < graph_->n(); u++) {
+      int b = labels_.Label(u);
+      if (b < 0 || b == a || pair_done[a][b] || !solution_c_value[v].Has(u)) continue;
+      pair_done[a][b] = pair_done[b][a] = true;
+      sides.push_back({v, labels_.Neighbors(b)});
     }
   }
-  Log::Write(20, "Found minsep of size ", minsep.size());
-  std::vector<std::vector<int> > components = graph_.Components(minsep);
+  std::set<std::vector<int> > blocked = {minsep};
+  for (const auto& side : sides) {
+    graph_->LabelComponents(side.second, labels_);
+    std::vector<int> new_minsep = labels_.Neighbors(labels_.Label(side.first));
+    if (!blocked.insert(new_minsep).second) continue;
+    Log::Write(20, "Found broken pair minsep of size ", new_minsep.size());
+    BlockMinsep(new_minsep, solution_c_value, solution);
+  }
+}
+
+void Enumerator::BlockMinsep(const std::vector<int>& minsep, const std::vector<Bitset>& solution_c_value, const std::vector<int>& solution) {
+  std::vector<std::vector<int> > components = graph_->Components(minsep);
   assert(components.size() >= 2);
   int vars_added = 0;
   int clauses_added = 0;
   Lit minsep_var;
   assert(utils::IsSorted(minsep));
-  if (minsep_vars_.count(minsep)) {
+  int minsep_id = minseps_.IdOf(minsep);
+  if (minsep_id != -1) {
     Log::Write(30, "Minsep already known");
-    minsep_var = minsep_vars_[minsep];
+    minsep_var = minsep_vars_[minsep_id];
   }
   else {
     Log::Write(30, "New minsep");
-    enumerator_stats_.MinsepFound();
-    minsep_var = solver_->NewVar();
-    if (minsep_encoding_ != 0 && minsep_encoding_ != 5) {
-      // In some encodings we might refer the variable again, so it should be frozen.
-      solver_->FreezeVar(minsep_var);
-    }
-    minsep_vars_[minsep] = minsep_var;
+    minsep_var = NewMinsepVar(minsep);
     vars_added++;
-    std::vector<Lit> minsep_clause = {minsep_var};
-    for (int v : minsep) {
-      minsep_clause.push_back(-x_var_[v]);
-    }
-    solver_->AddClause(minsep_clause);
     clauses_added++;
-    if (minsep_encoding_ == 5) {
-      for (int v : minsep) {
-        solver_->AddClause({-minsep_var, x_var_[v]});
-      }
-    }
   }
   switch (minsep_encoding_) {
     case 0:
     case 5:
     {
       // Add all pairs of vertices
-      for (int i = 0; i < components.size(); i++) {
-        for (int ii = i + 1; ii < components.size(); ii++) {
-          for (int v : components[i]) {
-            for (int u : components[ii]) {
-              solver_->AddClause({-minsep_var, -c_var_[v][u]});
-              clauses_added++;
-            }
-          }
-        }
-      }
+      clauses_added += BlockAllPairs(minsep_var, components);
       break;
     }
     case 1: {
@@ -220,7 +436,7 @@ void Enumerator::BlockBadSolution(std::vector<int> solution) {
         for (int ii = i + 1; ii < components.size(); ii++) {
           for (int v : components[i]) {
             for (int u : components[ii]) {
-              if (solution_c_value[v][u]) {
+              if (solution_c_value[v].Has(u)) {
                 solver_->AddClause({-minsep_var, -c_var_[v][u]});
                 clauses_added++;
               }
@@ -239,7 +455,7 @@ void Enumerator::BlockBadSolution(std::vector<int> solution) {
           std::shuffle(components[ii].begin(), components[ii].end(), random_gen_);
           for (int v : components[i]) {
             for (int u : components[ii]) {
-              if (solution_c_value[v][u]) {
+              if (solution_c_value[v].Has(u)) {
                 solver_->AddClause({-minsep_var, -c_var_[v][u]});
                 clauses_added++;
                 found = true;
@@ -259,7 +475,7 @@ void Enumerator::BlockBadSolution(std::vector<int> solution) {
           bool broken = false;
           for (int v : components[i]) {
             for (int u : components[ii]) {
-              if (solution_c_value[v][u]) {
+              if (solution_c_value[v].Has(u)) {
                 broken = true;
                 break;
               }
@@ -278,6 +494,51 @@ void Enumerator::BlockBadSolution(std::vector<int> solution) {
       }
       break;
     }
+    case 7: {
+      // The connectivity variable of v and the representative of another component stands for v reaching that
+      // component. Blocking it for each v and component takes O(n * components) clauses instead of the O(n^2) of 0,
+      // and the connectivity implications propagate it back to the other vertices of the component along unselected
+      // vertices. The broken pairs are added as in 1 so that the current solution is always blocked.
+      if (minsep_id == -1) {
+        clauses_added += BlockRepresentatives(minsep_var, components);
+      }
+      for (int i = 0; i < components.size(); i++) {
+        for (int ii = i + 1; ii < components.size(); ii++) {
+          for (int v : components[i]) {
+            for (int u : components[ii]) {
+              if (solution_c_value[v].Has(u) && u != components[ii][0] && v != components[i][0]) {
+                solver_->AddClause({-minsep_var, -c_var_[v][u]});
+                clauses_added++;
+              }
+            }
+          }
+        }
+      }
+      break;
+    }
+    case 6: {
+      // Add the pairs that are broken in the current solution as in 1. If none of them are, the solution is bad only
+      // because of pairs inside the minsep, so it is blocked directly.
+      bool broken = false;
+      for (int i = 0; i < components.size(); i++) {
+        for (int ii = i + 1; ii < components.size(); ii++) {
+          for (int v : components[i]) {
+            for (int u : components[ii]) {
+              if (solution_c_value[v].Has(u)) {
+                solver_->AddClause({-minsep_var, -c_var_[v][u]});
+                clauses_added++;
+                broken = true;
+              }
+            }
+          }
+        }
+      }
+      if (!broken) {
+        solver_->AddClause(BlockingClause(solution));
+        clauses_added++;
+      }
+      break;
+    }
     default: {
       assert(false);
     }
@@ -286,15 +547,133 @@ void Enumerator::BlockBadSolution(std::vector<int> solution) {
   Log::Write(30, "Clauses added ", clauses_added);
 }
 
-std::vector<int> Enumerator::GetPmc(std::vector<Lit> assumptions, bool first_call) {
+Lit Enumerator::NewMinsepVar(const std::vector<int>& minsep) {
+  enumerator_stats_.MinsepFound();
+  Lit minsep_var = solver_->NewVar();
+  if (minsep_encoding_ != 0 && minsep_encoding_ != 5) {
+    // In some encodings we might refer the variable again, so it should be frozen.
+    solver_->FreezeVar(minsep_var);
+  }
+  minseps_.Insert(minsep);
+  minsep_vars_.push_back(minsep_var);
+  std::vector<Lit> minsep_clause = {minsep_var};
+  for (int v : minsep) {
+    minsep_clause.push_back(-x_var_[v]);
+  }
+  solver_->AddClause(minsep_clause);
+  if (minsep_encoding_ == 5) {
+    for (int v : minsep) {
+      solver_->AddClause({-minsep_var, x_var_[v]});
+    }
+  }
+  return minsep_var;
+}
+
+int Enumerator::BlockAllPairs(Lit minsep_var, const std::vector<std::vector<int> >& components) {
+  int clauses_added = 0;
+  for (int i = 0; i < components.size(); i++) {
+    for (int ii = i + 1; ii < components.size(); ii++) {
+      for (int v : components[i]) {
+        for (int u : components[ii]) {
+          solver_->AddClause({-minsep_var, -ConnectivityVar(v, u)});
+          clauses_added++;
+        }
+      }
+    }
+  }
+  return clauses_added;
+}
+
+int Enumerator::BlockRepresentatives(Lit minsep_var, const std::vector<std::vector<int> >& components) {
+  int clauses_added = 0;
+  for (int i = 0; i < components.size(); i++) {
+    for (int ii = 0; ii < components.size(); ii++) {
+      if (i == ii) continue;
+      int representative = components[ii][0];
+      for (int v : components[i]) {
+        solver_->AddClause({-minsep_var, -ConnectivityVar(v, representative)});
+        clauses_added++;
+      }
+    }
+  }
+  return clauses_added;
+}
+
+// The encodings that add all pairs of a minsep when they find it get all pairs of the seeds too. The others find
+// only the pairs that the solutions break, which are not known yet, so the seeds are blocked as in 7.
+void Enumerator::SeedMinseps() {
+  std::vector<std::vector<int> > seeds = comb_enumerator::FindMinSeps(*graph_, seed_minseps_);
+  if ((int)seeds.size() > seed_minseps_) seeds.resize(seed_minseps_);
+  int clauses_added = 0;
+  for (std::vector<int>& minsep : seeds) {
+    if (minsep.empty()) continue;
+    std::sort(minsep.begin(), minsep.end());
+    if (minseps_.IdOf(minsep) != -1) continue;
+    std::vector<std::vector<int> > components = graph_->Components(minsep);
+    assert(components.size() >= 2);
+    Lit minsep_var = NewMinsepVar(minsep);
+    if (minsep_encoding_ == 0 || minsep_encoding_ == 3 || minsep_encoding_ == 5) {
+      clauses_added += BlockAllPairs(minsep_var, components);
+    } else {
+      clauses_added += BlockRepresentatives(minsep_var, components);
+    }
+  }
+  Log::Write(10, "Seeded ", minseps_.Size(), " minseps with ", clauses_added, " clauses");
+}
+
+// Adds the clauses of the eager encoding that the solution violates: the no full component constraint of one vertex
+// of each full component and the clique constraint of each pair of the PMC that no component covers. If they are
+// all there already, the solution is wrong only about the connectivity and is blocked with a minsep.
+void Enumerator::RefineLazy(const std::vector<int>& solution) {
+  graph_->LabelComponents(solution, labels_);
+  bool refined = false;
+  for (int c = 0; c < labels_.NumComponents(); c++) {
+    if (labels_.Neighbors(c).size() < solution.size()) continue;
+    int v = 0;
+    while (labels_.Label(v) != c) v++;
+    assert(!lazy_row_[v]);
+    lazy_row_[v] = true;
+    AddConnectivityImplications(v);
+    AddNoFullComponent(v);
+    refined = true;
+  }
+  allowed_.Resize(graph_->n());
+  for (int i = 0; i < (int)solution.size(); i++) {
+    int v = solution[i];
+    allowed_.Clear();
+    for (int nv : graph_->Neighbors(v)) {
+      if (labels_.Label(nv) >= 0) {
+        for (int u : labels_.Neighbors(labels_.Label(nv))) allowed_.Set(u);
+      }
+    }
+    for (int ii = i + 1; ii < (int)solution.size(); ii++) {
+      int u = solution[ii];
+      if (graph_->HasEdge(v, u) || allowed_.Has(u) || lazy_pair_[v][u]) continue;
+      lazy_pair_[v][u] = lazy_pair_[u][v] = true;
+      solver_->AddClause({-x_var_[v], -x_var_[u], ConnectivityVar(v, u)});
+      refined = true;
+    }
+  }
+  if (!refined) BlockBadSolution(solution);
+}
+
+std::vector<Lit> Enumerator::BlockingClause(const std::vector<int>& solution) const {
+  std::vector<Lit> clause(x_var_.begin(), x_var_.end());
+  for (int v : solution) clause[v] = -x_var_[v];
+  return clause;
+}
+
+Pmc Enumerator::GetPmc(std::vector<Lit> assumptions, bool first_call) {
   while (true) {
     enumerator_stats_.SatCalled();
     bool sat = solver_->Solve(assumptions, first_call);
     if (!sat) return {};
     std::vector<Lit> block_clause;
     std::vector<int> solution;
-    for (int i = 0; i < graph_.n(); i++) {
-      if (solver_->SolutionValue(x_var_[i])) {
+    for (int i = 0; i < graph_->n(); i++) assert(x_var_[i].IsDef());
+    solver_->GetModel(x_var_.data(), graph_->n(), x_value_);
+    for (int i = 0; i < graph_->n(); i++) {
+      if (x_value_.Has(i)) {
         block_clause.push_back(-x_var_[i]);
         solution.push_back(i);
       }
@@ -304,11 +683,15 @@ std::vector<int> Enumerator::GetPmc(std::vector<Lit> assumptions, bool first_cal
         block_clause.push_back(x_var_[i]);
       }
     }
-    if (graph_.IsPmc(solution)) {
+    Pmc pmc;
+    if (graph_->IsPmc(solution, labels_, pmc)) {
       enumerator_stats_.PmcFound();
       Log::Write(20, "Found pmc of size ", solution.size());
       solver_->AddClause(block_clause);
-      return solution;
+      return pmc;
+    }
+    else if (minsep_encoding_ == 6) {
+      RefineLazy(solution);
     }
     else {
       BlockBadSolution(solution);
@@ -3,12 +3,14 @@
 // Base class for enumerating PMCs with SAT.
 
 #include <vector>
-#include <map>
 #include <memory>
 #include <random>
 
 #include "sat_interface.hpp"
 #include "graph.hpp"
+#include "matrix.hpp"
+#include "bitset.hpp"
+#include "id_set.hpp"
 
 namespace triangulator {
 
@@ -28,7 +30,20 @@ private:
 
 class Enumerator {
 public:
-  Enumerator(const Graph& graph, std::shared_ptr<SatInterface> solver, int minsep_encoding);
+  // minsep_encoding 0-5 build the connectivity encoding for all pairs of vertices up front. 6 starts from the
+  // selection variables only and adds the connectivity variables and clauses of the vertices and pairs that the
+  // candidates violate, blocking the rest of the bad candidates with minseps as in 1. 7 is 0 with the pairs of each
+  // minsep replaced by the pairs of a vertex and a representative of another component. 4 and 8 make the
+  // connectivity exact, with path lengths in unary and with distances in binary, so that no minseps are needed.
+  Enumerator(SharedGraph graph, std::shared_ptr<SatInterface> solver, int minsep_encoding);
+
+  // The enumerators constructed after this register up to seed_minseps minseps of comb_enumerator::FindMinSeps with
+  // their blocking clauses before the first solve, instead of finding them from bad solutions one SAT call at a time.
+  // The encodings 4, 6 and 8 are not seeded.
+  static void SetSeedMinseps(int seed_minseps);
+  // If set, a bad solution is blocked with a minsep for each pair of its components that it connects, besides the
+  // minsep that the greedy minimization finds
+  static void SetMultipleMinseps(bool multiple_minseps);
 
   EnumeratorStats Stats() const;
   void PrintStats(int lvl) const;
@@ -37,20 +52,65 @@ public:
   Enumerator& operator=(const Enumerator&) = delete;
 protected:
   const std::vector<Lit>& XVars() const;
-  std::vector<int> GetPmc(std::vector<Lit> assumptions, bool first_call);
+  // Returns the next PMC together with its components, or a record without vertices if there are no more PMCs
+  Pmc GetPmc(std::vector<Lit> assumptions, bool first_call);
 private:
   std::vector<Lit> x_var_;
   Matrix<Lit> c_var_;
   std::shared_ptr<SatInterface> solver_;
-  std::map<std::vector<int>, Lit> minsep_vars_;
-  const Graph graph_;
+  // The minseps found so far and their variables, indexed by the ids of the minseps
+  VertexSetIds minseps_;
+  std::vector<Lit> minsep_vars_;
+  static int seed_minseps_;
+  static bool multiple_minseps_;
+  const SharedGraph graph_;
   const int minsep_encoding_;
   EnumeratorStats enumerator_stats_;
   std::mt19937 random_gen_;
+  // Buffers reused by IsBadSep and GetPmc
+  ComponentLabels labels_;
+  Bitset x_value_;
+  std::vector<Bitset> closure_;
+  Bitset allowed_;
+  std::vector<int> component_mark_;
+  // Buffers of MinimizeSeparator: a union-find over the vertices whose roots store the closed neighborhoods of their
+  // components, and the pairs of the solution that are not connected wrt. the current separator
+  std::vector<int> uf_parent_, merged_roots_;
+  std::vector<char> in_separator_;
+  std::vector<Bitset> root_closure_;
+  Bitset merged_;
+  std::vector<std::pair<int, int> > broken_pairs_;
+
+  // Only used by the lazy encoding 6: the vertices whose connectivity implications and no full component constraint
+  // have been added, and the pairs whose clique constraint has been added
+  std::vector<char> lazy_row_;
+  Matrix<char> lazy_pair_;
 
   void BuildBasicEncoding();
+  // Returns the connectivity variable of the pair, creating it if needed
+  Lit ConnectivityVar(int v, int u);
+  void AddConnectivityImplications(int v);
+  void AddNoFullComponent(int v);
+  void RefineLazy(const std::vector<int>& solution);
+  // The clause that excludes exactly the selection solution
+  std::vector<Lit> BlockingClause(const std::vector<int>& solution) const;
   void BuildPathLengthEncoding();
+  void BuildDistanceEncoding();
+  void AddLessThan(Lit condition, const std::vector<Lit>& a, const std::vector<Lit>& b);
   void BlockBadSolution(std::vector<int> solution);
-  bool IsBadSep(const std::vector<int>& separator, const Matrix<char>& solution_c_value) const;
+  // Adds the minsep if it is new and the clauses of the encoding that block the connectivity of the solution across it
+  void BlockMinsep(const std::vector<int>& minsep, const std::vector<Bitset>& solution_c_value, const std::vector<int>& solution);
+  void BlockBrokenPairMinseps(const std::vector<int>& solution, const std::vector<Bitset>& solution_c_value, const std::vector<int>& minsep);
+  // Registers a new minsep and adds the clause that sets its variable when it is selected
+  Lit NewMinsepVar(const std::vector<int>& minsep);
+  // Block the connectivity between the components of a minsep when its variable is set, returning the number of
+  // clauses added: all pairs of vertices, or each vertex and a representative of each other component
+  int BlockAllPairs(Lit minsep_var, const std::vector<std::vector<int> >& components);
+  int BlockRepresentatives(Lit minsep_var, const std::vector<std::vector<int> >& components);
+  void SeedMinseps();
+  // Returns a minimal subset of the bad separator that is still bad, dropping the vertices in order
+  std::vector<int> MinimizeSeparator(const std::vector<int>& separator, const std::vector<Bitset>& solution_c_value);
+  int FindRoot(int v);
+  bool IsBadSep(const std::vector<int>& separator, const std::vector<Bitset>& solution_c_value);
 };
 } // namespace triangulator
@@ -0,0 +1,160 @@
+#include "external_bt_algorithm.hpp"
+
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cassert>
+#include <algorithm>
+
+#include "graph.hpp"
+#include "bt_algorithm.hpp"
+#include "utils.hpp"
+
+namespace triangulator {
+
+size_t ExternalBtAlgorithmBase::default_run_bytes_ = 0;
+
+void ExternalBtAlgorithmBase::SetRunBytes(size_t run_bytes) {
+  default_run_bytes_ = run_bytes;
+}
+
+size_t ExternalBtAlgorithmBase::RunBytes() {
+  return default_run_bytes_;
+}
+
+size_t ExternalBtAlgorithmBase::FingerprintHash::operator()(const Fingerprint& fingerprint) const {
+  return fingerprint.first;
+}
+
+ExternalBtAlgorithmBase::ExternalBtAlgorithmBase(SharedGraph graph, size_t run_bytes) : graph_(graph), run_bytes_(run_bytes), pending_bytes_(0) {
+  assert(run_bytes_ > 0);
+  std::vector<int> all_vertices(graph_->n());
+  for (int i = 0; i < graph_->n(); i++) all_vertices[i] = i;
+  root_ = InsertState(all_vertices);
+}
+
+ExternalBtAlgorithmBase::~ExternalBtAlgorithmBase() {
+  for (FILE* run : runs_) fclose(run);
+}
+
+int ExternalBtAlgorithmBase::NumStates() const {
+  return states_.Size();
+}
+
+// Two independent 64-bit hashes of the sorted component
+int ExternalBtAlgorithmBase::InsertState(const std::vector<int>& component) {
+  uint64_t h1 = component.size();
+  uint64_t h2 = ~(uint64_t)component.size();
+  for (int x : component) {
+    h1 = (h1 ^ (uint64_t)x) * 0x9E3779B97F4A7C15ULL;
+    h1 ^= h1 >> 29;
+    h2 = (h2 + (uint64_t)x + 1) * 0xC2B2AE3D27D4EB4FULL;
+    h2 ^= h2 >> 31;
+  }
+  return states_.Insert({h1, h2});
+}
+
+// A record is stored as size, state, |pmc|, pmc, |separator|, separator, |children|, children
+void ExternalBtAlgorithmBase::AddRecord(int size, int state, const std::vector<int>& pmc, const std::vector<int>& separator, const std::vector<int>& children) {
+  pending_.push_back({size, state, {}});
+  std::vector<int>& data = pending_.back().data;
+  data.reserve(5 + pmc.size() + separator.size() + children.size());
+  data.push_back(size);
+  data.push_back(state);
+  data.push_back(pmc.size());
+  data.insert(data.end(), pmc.begin(), pmc.end());
+  data.push_back(separator.size());
+  data.insert(data.end(), separator.begin(), separator.end());
+  data.push_back(children.size());
+  data.insert(data.end(), children.begin(), children.end());
+  pending_bytes_ += sizeof(Pending) + data.size() * sizeof(int);
+  if (pending_bytes_ >= run_bytes_) FlushRun();
+}
+
+void ExternalBtAlgorithmBase::FlushRun() {
+  if (pending_.empty()) return;
+  std::stable_sort(pending_.begin(), pending_.end(), [](const Pending& a, const Pending& b) {
+    return a.size < b.size || (a.size == b.size && a.state < b.state);
+  });
+  FILE* run = std::tmpfile();
+  if (run == NULL) utils::ErrorDie("Could not create a temporary file for BT");
+  for (const Pending& p : pending_) {
+    if (fwrite(p.data.data(), sizeof(int), p.data.size(), run) != p.data.size()) utils::ErrorDie("Could not write BT triplets");
+  }
+  fflush(run);
+  runs_.push_back(run);
+  pending_.clear();
+  pending_.shrink_to_fit();
+  pending_bytes_ = 0;
+}
+
+void ExternalBtAlgorithmBase::AddPmcs(const std::vector<Pmc>& pmcs) {
+  for (const Pmc& pmc : pmcs) AddPmc(pmc);
+}
+
+void ExternalBtAlgorithmBase::AddPmcs(const PmcStore& pmcs) {
+  for (int i = 0; i < pmcs.Size(); i++) {
+    graph_->MakePmc(pmcs[i], ws_, record_);
+    AddPmc(record_);
+  }
+}
+
+void ExternalBtAlgorithmBase::AddPmc(const Pmc& pmc) {
+  FindPmcTriplets(pmc, triplets_);
+  std::vector<int> outer_ids, children;
+  for (const auto& outer : pmc.components) {
+    outer_ids.push_back(InsertState(outer.second));
+  }
+  for (int j = 0; j < (int)triplets_.inner.size(); j++) {
+    const auto& inner = triplets_.inner[j];
+    children.clear();
+    for (int c : triplets_.children[j]) children.push_back(outer_ids[c]);
+    AddRecord(inner.first.size() + inner.second.size(), InsertState(inner.second), pmc.vertices, inner.first, children);
+  }
+  AddRecord(graph_->n(), root_, pmc.vertices, {}, outer_ids);
+}
+
+bool ExternalBtAlgorithmBase::ReadNext(FILE* file, Record& record) {
+  int header[3];
+  if (fread(header, sizeof(int), 3, file) != 3) return false;
+  record.size = header[0];
+  record.state = header[1];
+  int length = header[2];
+  for (std::vector<int>* part : {&record.pmc, &record.separator, &record.children}) {
+    part->resize(length);
+    if (fread(part->data(), sizeof(int), length, file) != (size_t)length) utils::ErrorDie("Truncated BT record");
+    if (part != &record.children && fread(&length, sizeof(int), 1, file) != 1) utils::ErrorDie("Truncated BT record");
+  }
+  return true;
+}
+
+// The records still in memory are written out first so that every record has a location
+void ExternalBtAlgorithmBase::StartScan() {
+  FlushRun();
+  heads_.resize(runs_.size());
+  head_locations_.resize(runs_.size());
+  heap_ = decltype(heap_)();
+  for (int run = 0; run < (int)runs_.size(); run++) {
+    fseek(runs_[run], 0, SEEK_SET);
+    head_locations_[run] = {run, 0};
+    if (ReadNext(runs_[run], heads_[run])) heap_.push({{heads_[run].size, heads_[run].state}, run});
+  }
+}
+
+bool ExternalBtAlgorithmBase::NextRecord(Record& record, Location& location) {
+  if (heap_.empty()) return false;
+  int run = heap_.top().second;
+  heap_.pop();
+  std::swap(record, heads_[run]);
+  location = head_locations_[run];
+  head_locations_[run].offset = ftell(runs_[run]);
+  if (ReadNext(runs_[run], heads_[run])) heap_.push({{heads_[run].size, heads_[run].state}, run});
+  return true;
+}
+
+void ExternalBtAlgorithmBase::ReadRecord(Location location, Record& record) {
+  fseek(runs_[location.run], location.offset, SEEK_SET);
+  if (!ReadNext(runs_[location.run], record)) utils::ErrorDie("Missing BT record");
+}
+
+} // namespace triangulator
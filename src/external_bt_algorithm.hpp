@@ -0,0 +1,193 @@
+#pragma once
+
+// Out-of-core version of BtAlgorithm for PMC sets whose triplets do not fit in memory.
+// The triplets are written to temporary files in runs sorted by |S| + |C| and the DP merges the runs in that order.
+// In memory are the dp table, the location of the optimal record of each state, the pending run and a hash table
+// from a 128-bit fingerprint of the component of each state to the id of the state. The components themselves are
+// not stored, neither in memory nor on disk, so states are identified by the fingerprints only: two different
+// components that collide on both 64-bit hashes would be silently merged into one state.
+
+#include <vector>
+#include <queue>
+#include <cstdio>
+#include <cstdint>
+#include <limits>
+#include <cassert>
+
+#include "graph.hpp"
+#include "id_set.hpp"
+#include "workspace.hpp"
+#include "tree_decomposition.hpp"
+#include "bt_algorithm.hpp"
+
+namespace triangulator {
+// Interface
+class ExternalBtAlgorithmBase {
+public:
+  // Triplets are buffered in memory until they take run_bytes and then written out as a sorted run
+  ExternalBtAlgorithmBase(SharedGraph graph, size_t run_bytes);
+  ~ExternalBtAlgorithmBase();
+  void AddPmcs(const std::vector<Pmc>& pmcs);
+  void AddPmcs(const PmcStore& pmcs);
+
+  // The run size used by the solvers. 0, the default, keeps BT in memory.
+  static void SetRunBytes(size_t run_bytes);
+  static size_t RunBytes();
+
+  ExternalBtAlgorithmBase(const ExternalBtAlgorithmBase&) = delete;
+  ExternalBtAlgorithmBase& operator=(const ExternalBtAlgorithmBase&) = delete;
+protected:
+  struct Record {
+    // size is |S| + |C| of the state
+    int size, state;
+    std::vector<int> pmc, separator, children;
+  };
+  struct Location {
+    int run;
+    long offset;
+  };
+  const SharedGraph graph_;
+  int root_;
+
+  int NumStates() const;
+  // Iterates over all records in order of size. Records of the same state are consecutive.
+  void StartScan();
+  bool NextRecord(Record& record, Location& location);
+  void ReadRecord(Location location, Record& record);
+private:
+  typedef std::pair<uint64_t, uint64_t> Fingerprint;
+  struct FingerprintHash {
+    size_t operator()(const Fingerprint& fingerprint) const;
+  };
+  struct Pending {
+    int size, state;
+    std::vector<int> data;
+  };
+  HashIdSet<Fingerprint, FingerprintHash> states_;
+  const size_t run_bytes_;
+  size_t pending_bytes_;
+  std::vector<Pending> pending_;
+  std::vector<FILE*> runs_;
+  // The next record of each run during a scan, and a min-heap of ((size, state), run) over them
+  std::vector<Record> heads_;
+  std::vector<Location> head_locations_;
+  std::priority_queue<std::pair<std::pair<int, int>, int>, std::vector<std::pair<std::pair<int, int>, int> >, std::greater<std::pair<std::pair<int, int>, int> > > heap_;
+  TraversalWorkspace ws_;
+  Pmc record_;
+  PmcTriplets triplets_;
+  static size_t default_run_bytes_;
+
+  int InsertState(const std::vector<int>& component);
+  void AddRecord(int size, int state, const std::vector<int>& pmc, const std::vector<int>& separator, const std::vector<int>& children);
+  void AddPmc(const Pmc& pmc);
+  void FlushRun();
+  bool ReadNext(FILE* file, Record& record);
+};
+
+template<typename CostPolicy>
+class ExternalBtAlgorithm : public ExternalBtAlgorithmBase {
+public:
+  typedef typename CostPolicy::Cost Cost;
+
+  ExternalBtAlgorithm(SharedGraph graph, size_t run_bytes);
+  // Same as BtAlgorithm::Solve
+  std::pair<Cost, std::vector<Edge> > Solve();
+  // Same as BtAlgorithm::Feasible
+  bool Feasible(Cost bound);
+  // Same as BtAlgorithm::Decomposition
+  const TreeDecomposition& Decomposition() const;
+private:
+  std::vector<Cost> dp_;
+  std::vector<Location> opt_location_;
+  TreeDecomposition decomposition_;
+
+  static Cost NotRealized();
+  Cost RecordCost(const Record& record, Cost bound) const;
+  void Pass(Cost bound);
+  std::vector<Edge> Reconstruct();
+};
+
+
+// Implementation
+template<typename CostPolicy>
+ExternalBtAlgorithm<CostPolicy>::ExternalBtAlgorithm(SharedGraph graph, size_t run_bytes)
+  : ExternalBtAlgorithmBase(graph, run_bytes) { }
+
+template<typename CostPolicy>
+typename ExternalBtAlgorithm<CostPolicy>::Cost ExternalBtAlgorithm<CostPolicy>::NotRealized() {
+  return std::numeric_limits<Cost>::max();
+}
+
+template<typename CostPolicy>
+typename ExternalBtAlgorithm<CostPolicy>::Cost ExternalBtAlgorithm<CostPolicy>::RecordCost(const Record& record, Cost bound) const {
+  Cost cost = CostPolicy::CliqueCost(*graph_, record.pmc, record.separator);
+  if (cost > bound) return NotRealized();
+  for (int child : record.children) {
+    if (dp_[child] == NotRealized()) return NotRealized();
+    cost = CostPolicy::MergeCost(cost, dp_[child]);
+    if (cost > bound) return NotRealized();
+  }
+  return cost;
+}
+
+// Same invariant as in BtAlgorithm::Pass
+template<typename CostPolicy>
+void ExternalBtAlgorithm<CostPolicy>::Pass(Cost bound) {
+  dp_.resize(NumStates(), NotRealized());
+  opt_location_.resize(NumStates());
+  Record record;
+  Location location;
+  StartScan();
+  while (NextRecord(record, location)) {
+    Cost cost = RecordCost(record, bound);
+    if (cost < dp_[record.state]) {
+      dp_[record.state] = cost;
+      opt_location_[record.state] = location;
+    }
+  }
+}
+
+template<typename CostPolicy>
+std::pair<typename ExternalBtAlgorithm<CostPolicy>::Cost, std::vector<Edge> > ExternalBtAlgorithm<CostPolicy>::Solve() {
+  Pass(NotRealized() - 1);
+  if (dp_[root_] == NotRealized()) return {-1, {}};
+  return {dp_[root_], Reconstruct()};
+}
+
+template<typename CostPolicy>
+bool ExternalBtAlgorithm<CostPolicy>::Feasible(Cost bound) {
+  assert(bound < NotRealized());
+  Pass(bound);
+  return dp_[root_] <= bound;
+}
+
+template<typename CostPolicy>
+const TreeDecomposition& ExternalBtAlgorithm<CostPolicy>::Decomposition() const {
+  return decomposition_;
+}
+
+template<typename CostPolicy>
+std::vector<Edge> ExternalBtAlgorithm<CostPolicy>::Reconstruct() {
+  std::vector<Edge> fill_edges;
+  decomposition_ = TreeDecomposition();
+  std::queue<std::pair<int, int> > reconstruct;
+  reconstruct.push({root_, -1});
+  Record record;
+  while (!reconstruct.empty()) {
+    int state = reconstruct.front().first;
+    int parent_bag = reconstruct.front().second;
+    reconstruct.pop();
+    assert(dp_[state] != NotRealized());
+    ReadRecord(opt_location_[state], record);
+    assert(record.state == state);
+    AddBagFill(*graph_, record.pmc, record.separator, fill_edges);
+    int bag = decomposition_.AddBag(record.pmc);
+    if (parent_bag != -1) decomposition_.AddEdge(parent_bag, bag);
+    for (int child : record.children) {
+      assert(dp_[child] != NotRealized());
+      reconstruct.push({child, bag});
+    }
+  }
+  return fill_edges;
+}
+} // namespace triangulator
@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <cassert>
+#include <algorithm>
 
 #include "graph.hpp"
 #include "sat_interface.hpp"
@@ -10,25 +11,40 @@
 
 namespace triangulator {
 
-FixedSizeEnumerator::FixedSizeEnumerator(const Graph& graph, std::shared_ptr<SatInterface> solver, int minsep_encoding, int card_encoding)
+FixedSizeEnumerator::FixedSizeEnumerator(SharedGraph graph, std::shared_ptr<SatInterface> solver, int minsep_encoding, int card_encoding, const std::vector<int>& weights)
   : Enumerator(graph, solver, minsep_encoding), card_encoding_(card_encoding), tb_(solver) {
+  std::vector<Lit> input = XVars();
+  if (!weights.empty()) {
+    assert((int)weights.size() == graph->n());
+    input.clear();
+    for (int v = 0; v < graph->n(); v++) {
+      assert(weights[v] >= 0);
+      for (int i = 0; i < weights[v]; i++) input.push_back(XVars()[v]);
+    }
+    // The cardinality network needs at least two inputs
+    while (input.size() < 2) input.push_back(Lit::FalseLit());
+  }
   if (card_encoding == 0) {
     CardinalityNetworkBuilder ccb(solver);
-    cardinality_network_ = ccb.EqualNetwork(XVars());
+    cardinality_network_ = ccb.EqualNetwork(input);
   } else if (card_encoding == 1) {
-    cardinality_network_ = tb_.Init(XVars());
+    cardinality_network_ = tb_.Init(input);
   } else {
     assert(0);
   }
-  assert(cardinality_network_.size() == (int)graph.n());
+  assert(cardinality_network_.size() == input.size());
   for (Lit var : cardinality_network_) {
     solver->FreezeVar(var);
   }
 }
 
-std::vector<std::vector<int>> FixedSizeEnumerator::AllPmcs(int k) {
-  if (card_encoding_ == 1) {
-    tb_.BuildToSize(k+1);
+int FixedSizeEnumerator::MaxSize() const {
+  return cardinality_network_.size();
+}
+
+std::vector<Pmc> FixedSizeEnumerator::AllPmcs(int k) {
+  if (card_encoding_ == 1 && MaxSize() > 0) {
+    tb_.BuildToSize(std::min(k+1, MaxSize()));
   }
   std::vector<Lit> assumptions;
   for (int i = 0; i < (int)cardinality_network_.size(); i++) {
@@ -38,15 +54,15 @@ std::vector<std::vector<int>> FixedSizeEnumerator::AllPmcs(int k) {
       assumptions.push_back(-cardinality_network_[i]);
     }
   }
-  std::vector<std::vector<int>> pmcs;
+  std::vector<Pmc> pmcs;
   bool first_call = true;
   while (true) {
-    auto pmc = GetPmc(assumptions, first_call);
+    Pmc pmc = GetPmc(assumptions, first_call);
     first_call = false;
-    if (pmc.size() == 0) {
+    if (pmc.vertices.size() == 0) {
       break;
     } else {
-      pmcs.push_back(pmc);
+      pmcs.push_back(std::move(pmc));
     }
   }
   return pmcs;
@@ -11,8 +11,13 @@ namespace triangulator {
 
 class FixedSizeEnumerator : public Enumerator {
 public:
-  FixedSizeEnumerator(const Graph& graph, std::shared_ptr<SatInterface> solver, int minsep_encoding, int card_encoding);
-  std::vector<std::vector<int>> AllPmcs(int k);
+  // If weights are given, the size of a PMC is the sum of the weights of its vertices. The weights are encoded by
+  // repeating each x variable weight times in the input of the cardinality encoding, which turns it into a
+  // pseudo-Boolean constraint.
+  FixedSizeEnumerator(SharedGraph graph, std::shared_ptr<SatInterface> solver, int minsep_encoding, int card_encoding, const std::vector<int>& weights = {});
+  std::vector<Pmc> AllPmcs(int k);
+  // The largest possible size of a PMC
+  int MaxSize() const;
 private:
   std::vector<Lit> cardinality_network_;
   int card_encoding_;
@@ -12,7 +12,7 @@
 namespace triangulator {
 
 FixedSizeHyperEnumerator::FixedSizeHyperEnumerator(const HyperGraph& graph, std::shared_ptr<SatInterface> solver, int minsep_encoding, int card_encoding)
-  : Enumerator(graph.PrimalGraph(), solver, minsep_encoding), card_encoding_(card_encoding), tb_(solver) {
+  : Enumerator(graph.SharedPrimalGraph(), solver, minsep_encoding), card_encoding_(card_encoding), tb_(solver) {
   std::vector<Lit> edge_vars;
   std::vector<std::vector<int> > in_edge(graph.n());
   for (int i = 0; i < graph.m(); i++) {
@@ -44,7 +44,7 @@ FixedSizeHyperEnumerator::FixedSizeHyperEnumerator(const HyperGraph& graph, std:
   }
 }
 
-std::vector<std::vector<int>> FixedSizeHyperEnumerator::AllPmcs(int k) {
+std::vector<Pmc> FixedSizeHyperEnumerator::AllPmcs(int k) {
   if (card_encoding_ == 1) {
     tb_.BuildToSize(k+1);
   }
@@ -56,15 +56,15 @@ std::vector<std::vector<int>> FixedSizeHyperEnumerator::AllPmcs(int k) {
       assumptions.push_back(-cardinality_network_[i]);
     }
   }
-  std::vector<std::vector<int>> pmcs;
+  std::vector<Pmc> pmcs;
   bool first_call = true;
   while (true) {
-    auto pmc = GetPmc(assumptions, first_call);
+    Pmc pmc = GetPmc(assumptions, first_call);
     first_call = false;
-    if (pmc.size() == 0) {
+    if (pmc.vertices.size() == 0) {
       break;
     } else {
-      pmcs.push_back(pmc);
+      pmcs.push_back(std::move(pmc));
     }
   }
   return pmcs;
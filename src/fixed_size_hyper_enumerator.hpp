@@ -12,7 +12,7 @@ namespace triangulator {
 class FixedSizeHyperEnumerator : public Enumerator {
 public:
   FixedSizeHyperEnumerator(const HyperGraph& graph, std::shared_ptr<SatInterface> solver, int minsep_encoding, int card_encoding);
-  std::vector<std::vector<int>> AllPmcs(int k);
+  std::vector<Pmc> AllPmcs(int k);
 private:
   std::vector<Lit> cardinality_network_;
   int card_encoding_;
@@ -7,12 +7,13 @@
 #include <ostream>
 
 #include "utils.hpp"
-#include "matrix.hpp"
+#include "bitset.hpp"
 
 namespace triangulator {
 
 Graph::Graph(int n)
-  : n_(n), m_(0), adj_list_(n), adj_mat_(n, n) {
+  : n_(n), m_(0), sparse_(n > kSparseThreshold), adj_list_(n) {
+  InitAdjacency();
   std::vector<int> identity(n);
   for (int i = 0; i < n; i++) identity[i] = i;
   vertex_map_.Init(identity);
@@ -21,8 +22,9 @@ Graph::Graph(int n)
 Graph::Graph(std::vector<Edge> edges) : vertex_map_(edges) {
   n_ = vertex_map_.Size();
   m_ = 0;
+  sparse_ = n_ > kSparseThreshold;
   adj_list_.resize(n_);
-  adj_mat_.Resize(n_, n_);
+  InitAdjacency();
   for (auto edge : edges) {
     AddEdge(vertex_map_.Rank(edge.first), vertex_map_.Rank(edge.second));
   }
@@ -36,8 +38,30 @@ int Graph::m() const {
   return m_;
 }
 
+bool Graph::IsSparse() const {
+  return sparse_;
+}
+
+// Rows are padded to 1, 2 or 4 words on small graphs so that the fixed width kernels apply
+void Graph::InitAdjacency() {
+  words_ = (n_ + 63) / 64;
+  if (words_ < 1) words_ = 1;
+  if (words_ == 3) words_ = 4;
+  if (!sparse_) adj_words_.assign((size_t)n_ * words_, 0);
+}
+
+const uint64_t* Graph::Row(int v) const {
+  return adj_words_.data() + (size_t)v * words_;
+}
+
+long long Graph::EdgeKey(int v, int u) const {
+  if (v > u) std::swap(v, u);
+  return (long long)v * n_ + u;
+}
+
 bool Graph::HasEdge(int v, int u) const {
-  return adj_mat_[v][u];
+  if (sparse_) return edge_set_.count(EdgeKey(v, u)) > 0;
+  return (Row(v)[u >> 6] >> (u & 63)) & 1;
 }
 
 bool Graph::HasEdge(Edge e) const {
@@ -68,11 +92,15 @@ bool Graph::IsConnectedOrIsolated() const {
 }
 
 void Graph::AddEdge(int v, int u) {
-  if (adj_mat_[v][u]) return;
+  if (HasEdge(v, u)) return;
   assert(v != u);
   m_++;
-  adj_mat_[v][u] = true;
-  adj_mat_[u][v] = true;
+  if (sparse_) {
+    edge_set_.insert(EdgeKey(v, u));
+  } else {
+    adj_words_[(size_t)v * words_ + (u >> 6)] |= (uint64_t)1 << (u & 63);
+    adj_words_[(size_t)u * words_ + (v >> 6)] |= (uint64_t)1 << (v & 63);
+  }
   adj_list_[v].push_back(u);
   adj_list_[u].push_back(v);
 }
@@ -86,10 +114,14 @@ void Graph::AddEdges(const std::vector<Edge>& edges) {
 }
 
 void Graph::RemoveEdge(int v, int u) {
-  assert(adj_mat_[v][u] && adj_mat_[u][v]);
+  assert(HasEdge(v, u) && HasEdge(u, v));
   m_--;
-  adj_mat_[v][u] = false;
-  adj_mat_[u][v] = false;
+  if (sparse_) {
+    edge_set_.erase(EdgeKey(v, u));
+  } else {
+    adj_words_[(size_t)v * words_ + (u >> 6)] &= ~((uint64_t)1 << (u & 63));
+    adj_words_[(size_t)u * words_ + (v >> 6)] &= ~((uint64_t)1 << (v & 63));
+  }
   int fo = 0;
   for (int i = 0; i < adj_list_[v].size(); i++) {
     if (adj_list_[v][i] == u) {
@@ -118,31 +150,160 @@ int Graph::MinDegree() const {
   return mdg;
 }
 
-void Graph::Dfs(int v, std::vector<char>& block, std::vector<int>& component) const {
+std::vector<int> Graph::FindComponentAndMark(int v, std::vector<char>& block) const {
+  std::vector<int> component = {v};
   block[v] = true;
-  component.push_back(v);
-  for (int nv : adj_list_[v]) {
-    if (!block[nv]) {
-      Dfs(nv, block, component);
+  for (int i = 0; i < (int)component.size(); i++) {
+    for (int nv : adj_list_[component[i]]) {
+      if (!block[nv]) {
+        block[nv] = true;
+        component.push_back(nv);
+      }
     }
   }
+  return component;
 }
 
-std::vector<int> Graph::FindComponentAndMark(int v, std::vector<char>& block) const {
-  std::vector<int> component;
-  Dfs(v, block, component);
-  return component;
+void Graph::FindComponentAndMark(int v, TraversalWorkspace& ws) const {
+  assert(!ws.blocked.Has(v));
+  ws.seen.Clear(n_);
+  ws.component.clear();
+  ws.neighbors.clear();
+  ws.component.push_back(v);
+  ws.blocked.Set(v);
+  ws.seen.Set(v);
+  for (int i = 0; i < (int)ws.component.size(); i++) {
+    for (int nv : adj_list_[ws.component[i]]) {
+      if (ws.seen.Has(nv)) continue;
+      ws.seen.Set(nv);
+      if (ws.blocked.Has(nv)) {
+        ws.neighbors.push_back(nv);
+      } else {
+        ws.blocked.Set(nv);
+        ws.component.push_back(nv);
+      }
+    }
+  }
+}
+
+// The word-parallel kernels touch n/64 words per vertex while the list based ones touch the degree.
+// With at most 4 words per row the fixed width kernels are faster regardless of the density.
+bool Graph::UseBitKernels() const {
+  return !sparse_ && (words_ <= 4 || (long long)n_ * words_ <= 2LL * m_);
+}
+
+template<typename Set>
+Set Graph::VertexSet(const std::vector<int>& vs) const {
+  Set set(n_);
+  for (int v : vs) {
+    set.Set(v);
+  }
+  return set;
+}
+
+template<typename Set>
+std::vector<std::vector<int> > Graph::BitComponents(const std::vector<int>& separator) const {
+  Set remaining;
+  remaining.Fill(n_);
+  remaining -= VertexSet<Set>(separator);
+  Set frontier(n_), found(n_);
+  std::vector<std::vector<int> > components;
+  for (int v = remaining.First(); v != -1; v = remaining.First()) {
+    Set component(n_);
+    component.Set(v);
+    remaining.Reset(v);
+    for (int x = v; x != -1; x = frontier.First()) {
+      frontier.Reset(x);
+      if (found.SetIntersection(Row(x), remaining)) {
+        remaining -= found;
+        component |= found;
+        frontier |= found;
+      }
+    }
+    components.push_back(component.Elements());
+  }
+  return components;
+}
+
+template<typename Set>
+std::vector<int> Graph::BitNeighbors(const std::vector<int>& vs) const {
+  Set nbs(n_);
+  for (int v : vs) {
+    nbs.Union(Row(v));
+  }
+  for (int v : vs) {
+    nbs.Reset(v);
+  }
+  return nbs.Elements();
+}
+
+template<typename Set>
+bool Graph::BitIsClique(const std::vector<int>& clique) const {
+  Set in_clique = VertexSet<Set>(clique);
+  for (int v : clique) {
+    in_clique.Reset(v);
+    bool ok = in_clique.IsSubsetOf(Row(v));
+    in_clique.Set(v);
+    if (!ok) return false;
+  }
+  return true;
+}
+
+// Same check as the labelling version, with the components and the coverage of each vertex as packed sets
+template<typename Set>
+bool Graph::BitIsPmc(const std::vector<int>& pmc) const {
+  Set in_pmc = VertexSet<Set>(pmc);
+  Set remaining;
+  remaining.Fill(n_);
+  remaining -= in_pmc;
+  Set frontier(n_), found(n_);
+  std::vector<Set> covered(pmc.size(), Set(n_));
+  for (int v = remaining.First(); v != -1; v = remaining.First()) {
+    Set component(n_), neighbors(n_);
+    component.Set(v);
+    remaining.Reset(v);
+    for (int x = v; x != -1; x = frontier.First()) {
+      frontier.Reset(x);
+      neighbors.Union(Row(x));
+      if (found.SetIntersection(Row(x), remaining)) {
+        remaining -= found;
+        component |= found;
+        frontier |= found;
+      }
+    }
+    neighbors -= component;
+    if (neighbors == in_pmc) return false;
+    for (int i = 0; i < (int)pmc.size(); i++) {
+      if (neighbors.Has(pmc[i])) covered[i] |= neighbors;
+    }
+  }
+  for (int i = 0; i < (int)pmc.size(); i++) {
+    covered[i].Union(Row(pmc[i]));
+    covered[i].Set(pmc[i]);
+    if (!in_pmc.IsSubsetOf(covered[i])) return false;
+  }
+  return true;
 }
 
 std::vector<std::vector<int> > Graph::Components(const std::vector<int>& separator) const {
-  std::vector<char> blocked(n_);
+  if (UseBitKernels()) {
+    switch (words_) {
+      case 1: return BitComponents<FixedBitset<1> >(separator);
+      case 2: return BitComponents<FixedBitset<2> >(separator);
+      case 4: return BitComponents<FixedBitset<4> >(separator);
+      default: return BitComponents<Bitset>(separator);
+    }
+  }
+  TraversalWorkspace ws;
+  ws.blocked.Clear(n_);
   for (int v : separator) {
-    blocked[v] = true;
+    ws.blocked.Set(v);
   }
   std::vector<std::vector<int> > components;
   for (int i = 0; i < n_; i++) {
-    if (!blocked[i]) {
-      components.push_back(FindComponentAndMark(i, blocked));
+    if (!ws.blocked.Has(i)) {
+      FindComponentAndMark(i, ws);
+      components.push_back(ws.component);
     }
   }
   return components;
@@ -150,12 +311,20 @@ std::vector<std::vector<int> > Graph::Components(const std::vector<int>& separat
 
 // Returns the vector in sorted order
 std::vector<int> Graph::Neighbors(const std::vector<int>& vs) const {
-  std::vector<int> neighbors;
   int sum = 0;
   for (int v : vs) {
     sum += adj_list_[v].size();
   }
-  if (sum >= n_/4) { // Two cases for optimization
+  if (!sparse_ && (words_ <= 4 || (long long)vs.size() * words_ <= sum)) { // Three cases for optimization
+    switch (words_) {
+      case 1: return BitNeighbors<FixedBitset<1> >(vs);
+      case 2: return BitNeighbors<FixedBitset<2> >(vs);
+      case 4: return BitNeighbors<FixedBitset<4> >(vs);
+      default: return BitNeighbors<Bitset>(vs);
+    }
+  }
+  std::vector<int> neighbors;
+  if (sum >= n_/4) {
     std::vector<char> nbs(n_);
     for (int v : vs) {
       for (int nv : adj_list_[v]) {
@@ -200,55 +369,160 @@ std::vector<Edge> Graph::EdgesIn(const std::vector<int>& vs) const {
     }
     else {
       for (int nv : vs) {
-        if (adj_mat_[v][nv] && nv > v) edges.push_back({v, nv});
+        if (HasEdge(v, nv) && nv > v) edges.push_back({v, nv});
       }
     }
   }
   return edges;
 }
 
-Matrix<char> Graph::ConnectedMatrix(const std::vector<int>& separator) const {
-  Matrix<char> connected = adj_mat_;
-  std::vector<std::vector<int> > components = Components(separator);
-  for (auto component : components) {
-    std::vector<int> neighbors = Neighbors(component);
-    component.insert(component.end(), neighbors.begin(), neighbors.end());
-    for (int v : component) {
-      for (int u : component) {
-        connected[v][u] = true;
+int ComponentLabels::NumComponents() const {
+  return num_components_;
+}
+
+int ComponentLabels::Label(int v) const {
+  return label_[v];
+}
+
+const std::vector<int>& ComponentLabels::Neighbors(int component) const {
+  return neighbors_[component];
+}
+
+void Graph::LabelComponents(const std::vector<int>& separator, ComponentLabels& labels) const {
+  labels.label_.assign(n_, -2);
+  for (int v : separator) {
+    labels.label_[v] = -1;
+  }
+  int components = 0;
+  for (int i = 0; i < n_; i++) {
+    if (labels.label_[i] != -2) continue;
+    labels.label_[i] = components;
+    labels.stack_.push_back(i);
+    while (!labels.stack_.empty()) {
+      int v = labels.stack_.back();
+      labels.stack_.pop_back();
+      for (int nv : adj_list_[v]) {
+        if (labels.label_[nv] == -2) {
+          labels.label_[nv] = components;
+          labels.stack_.push_back(nv);
+        }
+      }
+    }
+    components++;
+  }
+  labels.num_components_ = components;
+  if ((int)labels.neighbors_.size() < components) labels.neighbors_.resize(components);
+  for (int c = 0; c < components; c++) {
+    labels.neighbors_[c].clear();
+  }
+  labels.component_mark_.assign(components, -1);
+  for (int v : separator) {
+    for (int nv : adj_list_[v]) {
+      int c = labels.label_[nv];
+      if (c >= 0 && labels.component_mark_[c] != v) {
+        labels.component_mark_[c] = v;
+        labels.neighbors_[c].push_back(v);
       }
     }
   }
-  return connected;
 }
 
 bool Graph::IsPmc(const std::vector<int>& pmc) const {
-  Matrix<char> connected = ConnectedMatrix(pmc);
-  std::vector<char> in_pmc(n_);
-  for (int v : pmc) {
-    in_pmc[v] = true;
+  ComponentLabels labels;
+  return IsPmc(pmc, labels);
+}
+
+bool Graph::UseBitIsPmc() const {
+  return !sparse_ && (words_ == 1 || words_ == 2 || words_ == 4);
+}
+
+// A PMC has no full component and every pair of its vertices is either adjacent or in the neighborhood of a common component
+bool Graph::IsPmc(const std::vector<int>& pmc, ComponentLabels& labels) const {
+  if (UseBitIsPmc()) {
+    switch (words_) {
+      case 1: return BitIsPmc<FixedBitset<1> >(pmc);
+      case 2: return BitIsPmc<FixedBitset<2> >(pmc);
+      case 4: return BitIsPmc<FixedBitset<4> >(pmc);
+    }
   }
-  for (int i = 0; i < n_; i++) {
-    if (in_pmc[i]) {
-      for (int v : pmc) {
-        if (i != v && !connected[i][v] && !adj_mat_[i][v]) return false;
-      }
-    } else {
-      int connected_to = 0;
-      for (int j = 0; j < n_; j++) {
-        if (connected[i][j] && in_pmc[j]) connected_to++;
+  LabelComponents(pmc, labels);
+  for (int c = 0; c < labels.num_components_; c++) {
+    assert(labels.neighbors_[c].size() <= pmc.size());
+    if (labels.neighbors_[c].size() == pmc.size()) return false;
+  }
+  labels.vertex_mark_.assign(n_, -1);
+  labels.component_mark_.assign(labels.num_components_, -1);
+  for (int i = 0; i < (int)pmc.size(); i++) {
+    int v = pmc[i];
+    int covered = 0;
+    labels.vertex_mark_[v] = i;
+    for (int nv : adj_list_[v]) {
+      int c = labels.label_[nv];
+      if (c == -1) {
+        if (labels.vertex_mark_[nv] != i) {
+          labels.vertex_mark_[nv] = i;
+          covered++;
+        }
+      } else if (labels.component_mark_[c] != i) {
+        labels.component_mark_[c] = i;
+        for (int u : labels.neighbors_[c]) {
+          if (labels.vertex_mark_[u] != i) {
+            labels.vertex_mark_[u] = i;
+            covered++;
+          }
+        }
       }
-      assert(connected_to <= pmc.size());
-      if (connected_to == pmc.size()) return false;
     }
+    if (covered + 1 < (int)pmc.size()) return false;
   }
   return true;
 }
 
+// The word-parallel check does not label the components, so they are labeled here only for the PMCs
+bool Graph::IsPmc(const std::vector<int>& pmc, ComponentLabels& labels, Pmc& record) const {
+  if (!IsPmc(pmc, labels)) return false;
+  if (UseBitIsPmc()) LabelComponents(pmc, labels);
+  record.vertices = pmc;
+  std::sort(record.vertices.begin(), record.vertices.end());
+  record.components.resize(labels.num_components_);
+  for (int c = 0; c < labels.num_components_; c++) {
+    record.components[c].first = labels.neighbors_[c];
+    std::sort(record.components[c].first.begin(), record.components[c].first.end());
+    record.components[c].second.clear();
+  }
+  for (int v = 0; v < n_; v++) {
+    if (labels.label_[v] >= 0) record.components[labels.label_[v]].second.push_back(v);
+  }
+  return true;
+}
+
+void Graph::MakePmc(VertexSpan pmc, TraversalWorkspace& ws, Pmc& record) const {
+  record.vertices.assign(pmc.begin(), pmc.end());
+  std::sort(record.vertices.begin(), record.vertices.end());
+  record.components.clear();
+  ws.blocked.Clear(n_);
+  for (int v : pmc) ws.blocked.Set(v);
+  for (int v = 0; v < n_; v++) {
+    if (ws.blocked.Has(v)) continue;
+    FindComponentAndMark(v, ws);
+    std::sort(ws.neighbors.begin(), ws.neighbors.end());
+    std::sort(ws.component.begin(), ws.component.end());
+    record.components.push_back({ws.neighbors, ws.component});
+  }
+}
+
 bool Graph::IsClique(const std::vector<int>& clique) const {
+  if (!sparse_ && (long long)clique.size() > 2LL * words_) {
+    switch (words_) {
+      case 1: return BitIsClique<FixedBitset<1> >(clique);
+      case 2: return BitIsClique<FixedBitset<2> >(clique);
+      case 4: return BitIsClique<FixedBitset<4> >(clique);
+      default: return BitIsClique<Bitset>(clique);
+    }
+  }
   for (int i = 0; i < clique.size(); i++) {
     for (int ii = i + 1; ii < clique.size(); ii++) {
-      if (!adj_mat_[clique[i]][clique[ii]]) return false;
+      if (!HasEdge(clique[i], clique[ii])) return false;
     }
   }
   return true;
@@ -281,6 +555,15 @@ std::vector<Edge> Graph::MapBack(std::vector<Edge> es) const {
   }
   return es;
 }
+void Graph::SetDomainSizes(std::vector<int> domain_sizes) {
+  assert((int)domain_sizes.size() == n_);
+  for (int d : domain_sizes) assert(d >= 1);
+  domain_sizes_ = std::move(domain_sizes);
+}
+int Graph::DomainSize(int v) const {
+  if (domain_sizes_.empty()) return 2;
+  return domain_sizes_[v];
+}
 void Graph::InheritMap(const Graph& parent) {
   vertex_map_ = StaticSet<int>(parent.MapBack(vertex_map_.Values()));
 }
@@ -2,17 +2,49 @@
 
 #include <vector>
 #include <ostream>
+#include <unordered_set>
+#include <memory>
 
 #include "utils.hpp"
 #include "staticset.hpp"
-#include "matrix.hpp"
+#include "bitset.hpp"
+#include "workspace.hpp"
+#include "pmc_store.hpp"
 
 namespace triangulator {
 
 typedef std::pair<int, int> Edge;
 
+// Labelling of the components of a graph with a separator removed.
+// Keep one of these around and pass it to the Graph methods to reuse its buffers between calls.
+class ComponentLabels {
+public:
+  int NumComponents() const;
+  // Returns the component of v, or -1 if v is in the separator
+  int Label(int v) const;
+  // Returns the vertices of the separator adjacent to the component, in the order of the separator
+  const std::vector<int>& Neighbors(int component) const;
+private:
+  int num_components_ = 0;
+  std::vector<int> label_;
+  std::vector<std::vector<int> > neighbors_;
+  std::vector<int> stack_, vertex_mark_, component_mark_;
+  friend class Graph;
+};
+
+// A PMC together with the components of G - PMC. They are found when the PMC is verified and reused by the BT
+// algorithm instead of being traversed again.
+struct Pmc {
+  std::vector<int> vertices;
+  // The separator N(C) and the component C of each component of G - vertices, all sorted
+  std::vector<std::pair<std::vector<int>, std::vector<int> > > components;
+};
+
 class Graph {
 public:
+  // Graphs with more vertices than this do not store an adjacency matrix
+  static constexpr int kSparseThreshold = 4096;
+
   explicit Graph(int n);
   explicit Graph(std::vector<Edge> edges);
   void AddEdge(int v, int u);
@@ -23,6 +55,7 @@ public:
   
   int n() const;
   int m() const;
+  bool IsSparse() const;
   bool HasEdge(int v, int u) const;
   bool HasEdge(Edge e) const;
   std::vector<Edge> Edges() const;
@@ -35,11 +68,19 @@ public:
   std::vector<std::vector<int> > Components(const std::vector<int>& separator) const;
   std::vector<int> Neighbors(const std::vector<int>& vs) const;
   std::vector<int> FindComponentAndMark(int v, std::vector<char>& block) const;
+  // Stores the component of v in ws.component and its neighborhood in ws.neighbors without allocating.
+  // The vertices of the component are added to ws.blocked.
+  void FindComponentAndMark(int v, TraversalWorkspace& ws) const;
   std::vector<Edge> EdgesIn(const std::vector<int>& vs) const;
-  // Two vertices are connected wrt. separator if there exists a path between them where all intermediate vertices are outside of the separator
-  Matrix<char> ConnectedMatrix(const std::vector<int>& separator) const;
-  
+  // Labels the components in O(n + m)
+  void LabelComponents(const std::vector<int>& separator, ComponentLabels& labels) const;
+
   bool IsPmc(const std::vector<int>& pmc) const;
+  bool IsPmc(const std::vector<int>& pmc, ComponentLabels& labels) const;
+  // Returns whether pmc is a PMC and if so stores it in record
+  bool IsPmc(const std::vector<int>& pmc, ComponentLabels& labels, Pmc& record) const;
+  // Stores pmc in record without checking that it is a PMC
+  void MakePmc(VertexSpan pmc, TraversalWorkspace& ws, Pmc& record) const;
   bool IsClique(const std::vector<int>& clique) const;
   
   int MapBack(int v) const;
@@ -51,16 +92,43 @@ public:
   
   void InheritMap(const Graph& parent);
 
+  // Domain sizes of the vertices as variables of a probabilistic model, used by the table size costs.
+  // The vertices are binary unless domain sizes are given. They are not kept by the graphs derived from this one.
+  void SetDomainSizes(std::vector<int> domain_sizes);
+  int DomainSize(int v) const;
+
   void Print(std::ostream& out) const;
   
   Graph(const Graph& rhs) = default;
   Graph& operator=(const Graph& rhs) = default;
+  Graph(Graph&& rhs) = default;
+  Graph& operator=(Graph&& rhs) = default;
   
 private:
   int n_, m_;
+  bool sparse_;
   StaticSet<int> vertex_map_;
+  std::vector<int> domain_sizes_;
   std::vector<std::vector<int> > adj_list_;
-  Matrix<char> adj_mat_;
-  void Dfs(int v, std::vector<char>& blocked, std::vector<int>& component) const;
+  // Exactly one of adj_words_ and edge_set_ is used, depending on sparse_
+  // Row v of the adjacency matrix is stored in adj_words_[v*words_, (v+1)*words_)
+  int words_;
+  std::vector<uint64_t> adj_words_;
+  std::unordered_set<long long> edge_set_;
+  long long EdgeKey(int v, int u) const;
+  const uint64_t* Row(int v) const;
+  void InitAdjacency();
+  bool UseBitKernels() const;
+  bool UseBitIsPmc() const;
+
+  // Word-parallel kernels. Instantiated with FixedBitset<words_> if words_ is 1, 2 or 4 and with Bitset otherwise.
+  template<typename Set> Set VertexSet(const std::vector<int>& vs) const;
+  template<typename Set> std::vector<std::vector<int> > BitComponents(const std::vector<int>& separator) const;
+  template<typename Set> std::vector<int> BitNeighbors(const std::vector<int>& vs) const;
+  template<typename Set> bool BitIsClique(const std::vector<int>& clique) const;
+  template<typename Set> bool BitIsPmc(const std::vector<int>& pmc) const;
 };
+
+// Immutable reference counted graph. Copying the handle does not copy the graph.
+typedef std::shared_ptr<const Graph> SharedGraph;
 } // namespace triangulator
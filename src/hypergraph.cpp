@@ -3,6 +3,7 @@
 #include <vector>
 #include <algorithm>
 #include <iostream>
+#include <memory>
 
 #include "utils.hpp"
 
@@ -21,17 +22,20 @@ std::vector<std::pair<int, int>> PrimalEdges(const std::vector<std::vector<int>>
 }
 } // namespace
 
-HyperGraph::HyperGraph(int n) : primal_(n) { }
+HyperGraph::HyperGraph(int n) : primal_(std::make_shared<Graph>(n)) { }
 
-HyperGraph::HyperGraph(std::vector<std::vector<int>> edges) : primal_(PrimalEdges(edges)), edges_(edges) {
+HyperGraph::HyperGraph(std::vector<std::vector<int>> edges) : primal_(std::make_shared<Graph>(PrimalEdges(edges))), edges_(edges) {
   for (auto& e : edges_) {
     for (int& v : e) {
-      v = primal_.MapInto(v);
+      v = primal_->MapInto(v);
     }
     utils::SortAndDedup(e);
   }
 }
-Graph HyperGraph::PrimalGraph() const {
+const Graph& HyperGraph::PrimalGraph() const {
+  return *primal_;
+}
+SharedGraph HyperGraph::SharedPrimalGraph() const {
   return primal_;
 }
 const std::vector<std::vector<int> >& HyperGraph::Edges() const {
@@ -39,7 +43,7 @@ const std::vector<std::vector<int> >& HyperGraph::Edges() const {
 }
 const std::vector<std::vector<int>> HyperGraph::EdgesIn(const std::vector<int>& vs) const {
   static std::vector<char> is;
-  utils::InitZero(is, primal_.n());
+  utils::InitZero(is, primal_->n());
   for (int v : vs) {
     is[v] = true;
   }
@@ -57,15 +61,16 @@ const std::vector<std::vector<int>> HyperGraph::EdgesIn(const std::vector<int>&
 }
 void HyperGraph::AddEdge(std::vector<int> edge) {
   utils::SortAndDedup(edge);
+  if (primal_.use_count() > 1) primal_ = std::make_shared<Graph>(*primal_);
   for (int i = 0; i < edge.size(); i++) {
     for (int ii = i + 1; ii < edge.size(); ii++) {
-      primal_.AddEdge(edge[i], edge[ii]);
+      primal_->AddEdge(edge[i], edge[ii]);
     }
   }
   edges_.push_back(edge);
 }
 void HyperGraph::Print(std::ostream& out) const {
-  primal_.Print(out);
+  primal_->Print(out);
   out<<"hes: "<<edges_.size()<<std::endl;
   for (auto& e : edges_) {
     out<<"e:";
@@ -76,7 +81,7 @@ void HyperGraph::Print(std::ostream& out) const {
   }
 }
 int HyperGraph::n() const {
-  return primal_.n();
+  return primal_->n();
 }
 int HyperGraph::m() const {
   return edges_.size();
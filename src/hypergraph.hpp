@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <iostream>
+#include <memory>
 
 #include "graph.hpp"
 
@@ -11,7 +12,8 @@ class HyperGraph {
 public:
   explicit HyperGraph(int n);
   explicit HyperGraph(std::vector<std::vector<int>> edges);
-  Graph PrimalGraph() const;
+  const Graph& PrimalGraph() const;
+  SharedGraph SharedPrimalGraph() const;
   const std::vector<std::vector<int>>& Edges() const;
   const std::vector<std::vector<int>> EdgesIn(const std::vector<int>& vs) const;
   void AddEdge(std::vector<int> edge);
@@ -19,7 +21,8 @@ public:
   int n() const;
   int m() const;
 private:
-  Graph primal_;
+  // Shared between copies of the hypergraph, copied on write
+  std::shared_ptr<Graph> primal_;
   std::vector<std::vector<int>> edges_;
 };
 
@@ -1,45 +1,174 @@
 #pragma once
 
-#include <map>
 #include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cassert>
+
+#include "pmc_store.hpp"
 
 namespace triangulator {
 // Interface
-template<typename T>
-class IdSet {
+// Assigns consecutive ids to distinct elements, with open addressing hashing. Lookups do not copy the element.
+template<typename T, typename Hash>
+class HashIdSet {
 public:
-  int Insert(T);
-  const T& Get(int) const;
-  int IdOf(T) const;
-  
-  IdSet() = default;
-  IdSet(const IdSet& rhs) = default;
-  IdSet& operator=(const IdSet& rhs) = default;
+  int Insert(const T& element);
+  const T& Get(int i) const;
+  // Returns -1 if the element is not in the set
+  int IdOf(const T& element) const;
+  int Size() const;
+
+  HashIdSet() = default;
+  HashIdSet(const HashIdSet& rhs) = default;
+  HashIdSet& operator=(const HashIdSet& rhs) = default;
 private:
-  std::map<T, int> ids_;
   std::vector<T> elements_;
+  std::vector<size_t> hashes_;
+  // Ids of the elements or -1 for empty slots. The size is a power of two and at least twice the number of elements.
+  std::vector<int> slots_;
+  Hash hash_;
+  size_t FindSlot(const T& element, size_t hash) const;
+  void Grow();
+};
+
+// Ids for sorted vertex sets. The sets are stored back to back in a PmcStore and hashed by the words of their
+// bitsets, which are computed from the sorted vertices without building the bitset. Lookups take a VertexSpan, so
+// neither vectors nor the stored sets are copied.
+class VertexSetIds {
+public:
+  int Insert(VertexSpan vs);
+  VertexSpan Get(int i) const;
+  // Returns -1 if the set is not in the table
+  int IdOf(VertexSpan vs) const;
+  int Size() const;
+private:
+  PmcStore sets_;
+  std::vector<uint64_t> hashes_;
+  // Same as in HashIdSet
+  std::vector<int> slots_;
+  static uint64_t Hash(VertexSpan vs);
+  size_t FindSlot(VertexSpan vs, uint64_t hash) const;
+  void Grow();
 };
 
 
 // Implementation
-template<typename T>
-int IdSet<T>::Insert(T element) {
-  if (ids_.count(element)) {
-    return ids_[element];
-  } else {
-    ids_[element] = elements_.size();
+template<typename T, typename Hash>
+int HashIdSet<T, Hash>::Insert(const T& element) {
+  if (2 * (elements_.size() + 1) > slots_.size()) Grow();
+  size_t hash = hash_(element);
+  size_t slot = FindSlot(element, hash);
+  if (slots_[slot] == -1) {
+    slots_[slot] = elements_.size();
     elements_.push_back(element);
-    return elements_.size() - 1;
+    hashes_.push_back(hash);
   }
+  return slots_[slot];
 }
 
-template<typename T>
-const T& IdSet<T>::Get(int i) const {
+template<typename T, typename Hash>
+const T& HashIdSet<T, Hash>::Get(int i) const {
   return elements_[i];
 }
 
-template<typename T>
-int IdSet<T>::IdOf(T element) const {
-  return ids_.find(element)->second;
+template<typename T, typename Hash>
+int HashIdSet<T, Hash>::IdOf(const T& element) const {
+  if (slots_.empty()) return -1;
+  return slots_[FindSlot(element, hash_(element))];
+}
+
+template<typename T, typename Hash>
+int HashIdSet<T, Hash>::Size() const {
+  return elements_.size();
+}
+
+template<typename T, typename Hash>
+size_t HashIdSet<T, Hash>::FindSlot(const T& element, size_t hash) const {
+  size_t mask = slots_.size() - 1;
+  for (size_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+    int id = slots_[slot];
+    if (id == -1 || (hashes_[id] == hash && elements_[id] == element)) return slot;
+  }
+}
+
+template<typename T, typename Hash>
+void HashIdSet<T, Hash>::Grow() {
+  slots_.assign(slots_.empty() ? 16 : 2 * slots_.size(), -1);
+  size_t mask = slots_.size() - 1;
+  for (int id = 0; id < (int)elements_.size(); id++) {
+    size_t slot = hashes_[id] & mask;
+    while (slots_[slot] != -1) slot = (slot + 1) & mask;
+    slots_[slot] = id;
+  }
+}
+
+inline uint64_t VertexSetIds::Hash(VertexSpan vs) {
+  assert(std::is_sorted(vs.begin(), vs.end()));
+  uint64_t hash = 0;
+  uint64_t word = 0;
+  int word_index = -1;
+  auto mix = [&]() {
+    hash = (hash ^ (word + (uint64_t)word_index * 0x9E3779B97F4A7C15ULL)) * 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 32;
+  };
+  for (int v : vs) {
+    if ((v >> 6) != word_index) {
+      if (word_index != -1) mix();
+      word_index = v >> 6;
+      word = 0;
+    }
+    word |= (uint64_t)1 << (v & 63);
+  }
+  if (word_index != -1) mix();
+  return hash;
+}
+
+inline int VertexSetIds::Insert(VertexSpan vs) {
+  if (2 * (sets_.Size() + 1) > (int)slots_.size()) Grow();
+  uint64_t hash = Hash(vs);
+  size_t slot = FindSlot(vs, hash);
+  if (slots_[slot] == -1) {
+    slots_[slot] = sets_.Size();
+    sets_.Add(vs);
+    hashes_.push_back(hash);
+  }
+  return slots_[slot];
+}
+
+inline VertexSpan VertexSetIds::Get(int i) const {
+  return sets_[i];
+}
+
+inline int VertexSetIds::IdOf(VertexSpan vs) const {
+  if (slots_.empty()) return -1;
+  return slots_[FindSlot(vs, Hash(vs))];
+}
+
+inline int VertexSetIds::Size() const {
+  return sets_.Size();
+}
+
+inline size_t VertexSetIds::FindSlot(VertexSpan vs, uint64_t hash) const {
+  size_t mask = slots_.size() - 1;
+  for (size_t slot = hash & mask; ; slot = (slot + 1) & mask) {
+    int id = slots_[slot];
+    if (id == -1) return slot;
+    if (hashes_[id] == hash) {
+      VertexSpan set = sets_[id];
+      if (set.size() == vs.size() && std::equal(vs.begin(), vs.end(), set.begin())) return slot;
+    }
+  }
+}
+
+inline void VertexSetIds::Grow() {
+  slots_.assign(slots_.empty() ? 16 : 2 * slots_.size(), -1);
+  size_t mask = slots_.size() - 1;
+  for (int id = 0; id < sets_.Size(); id++) {
+    size_t slot = hashes_[id] & mask;
+    while (slots_[slot] != -1) slot = (slot + 1) & mask;
+    slots_[slot] = id;
+  }
 }
 } // namespace triangulator
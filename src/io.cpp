@@ -3,12 +3,14 @@
 #include <vector>
 #include <string>
 #include <istream>
+#include <ostream>
 #include <sstream>
 #include <algorithm>
 #include <cassert>
 
 #include "graph.hpp"
 #include "utils.hpp"
+#include "tree_decomposition.hpp"
 
 namespace triangulator {
 
@@ -34,12 +36,19 @@ std::vector<std::string> GetTokens(std::string s) {
 
 Graph Io::ReadGraph(std::istream& in) {
   std::vector<std::pair<std::string, std::string> > edges;
+  std::vector<std::pair<std::string, int> > domain_sizes;
   std::string input_line;
   bool format_detected = false;
   dimacs_ = false;
+  num_vertices_ = 0;
+  first_vertex_ = 0;
   int line_num = 0;
   while (std::getline(in, input_line)) {
     line_num++;
+    if (line_num == 1 && (input_line.compare(0, 5, "BAYES") == 0 || input_line.compare(0, 6, "MARKOV") == 0)) {
+      Log::Write(10, "UAI format detected");
+      return ReadUai(in);
+    }
     assert(input_line.size() > 0);
     if (input_line.size() >= 2 && input_line.substr(0, 2) == "p " && NumTokens(input_line) >= 3) {
       if (format_detected) {
@@ -47,21 +56,107 @@ Graph Io::ReadGraph(std::istream& in) {
       }
       Log::Write(10, "Dimacs graph format detected");
       edges.clear();
+      domain_sizes.clear();
+      auto tokens = GetTokens(input_line);
+      num_vertices_ = std::stoi(tokens[tokens.size() - 2]);
+      first_vertex_ = (tokens[1] == "tw") ? 1 : 0;
       dimacs_ = true;
       format_detected = true;
     } else if (dimacs_ && input_line.size() >= 2 && input_line.substr(0, 2) == "e " && NumTokens(input_line) == 3) {
       auto tokens = GetTokens(input_line);
       assert(tokens[0] == "e");
       edges.push_back({tokens[1], tokens[2]});
+    } else if (dimacs_ && input_line.size() >= 2 && input_line.substr(0, 2) == "n " && NumTokens(input_line) == 3) {
+      auto tokens = GetTokens(input_line);
+      domain_sizes.push_back({tokens[1], std::stoi(tokens[2])});
     }
   }
-  vertex_map_.Init(edges);
+  // The vertices without edges are left out, except the ones with a domain size since their tables still count
+  std::vector<std::string> vertices;
+  for (const auto& edge : edges) {
+    vertices.push_back(edge.first);
+    vertices.push_back(edge.second);
+  }
+  for (const auto& domain_size : domain_sizes) vertices.push_back(domain_size.first);
+  vertex_map_.Init(vertices);
   Graph graph(vertex_map_.Size());
   for (auto edge : edges) {
     graph.AddEdge(vertex_map_.Rank(edge.first), vertex_map_.Rank(edge.second));
   }
+  if (!domain_sizes.empty()) {
+    std::vector<int> sizes(graph.n(), 2);
+    for (const auto& domain_size : domain_sizes) sizes[vertex_map_.Rank(domain_size.first)] = domain_size.second;
+    graph.SetDomainSizes(sizes);
+  }
   return graph;
 }
+
+// The preamble of the UAI format: the number of variables, their domain sizes, the number of functions and the scope
+// of each function. The vertices are named by the indices of the variables and the function tables are not read.
+// Every variable is a vertex, also the ones that are not in the scope of any function with others.
+Graph Io::ReadUai(std::istream& in) {
+  int num_vars, num_functions;
+  in>>num_vars;
+  assert(in && num_vars >= 0);
+  num_vertices_ = num_vars;
+  first_vertex_ = 0;
+  std::vector<int> cardinalities(num_vars);
+  for (int& cardinality : cardinalities) in>>cardinality;
+  in>>num_functions;
+  assert(in && num_functions >= 0);
+  std::vector<std::pair<std::string, std::string> > edges;
+  for (int f = 0; f < num_functions; f++) {
+    int scope_size;
+    in>>scope_size;
+    std::vector<std::string> scope(scope_size);
+    for (std::string& var : scope) in>>var;
+    assert(in);
+    auto scope_edges = utils::CompleteEdges(scope);
+    edges.insert(edges.end(), scope_edges.begin(), scope_edges.end());
+  }
+  std::vector<std::string> vertices(num_vars);
+  for (int var = 0; var < num_vars; var++) vertices[var] = std::to_string(var);
+  vertex_map_.Init(vertices);
+  Graph graph(vertex_map_.Size());
+  std::vector<int> sizes(graph.n());
+  for (int v = 0; v < graph.n(); v++) {
+    int var = std::stoi(vertex_map_.Kth(v));
+    assert(var >= 0 && var < num_vars);
+    sizes[v] = cardinalities[var];
+  }
+  for (auto edge : edges) {
+    graph.AddEdge(vertex_map_.Rank(edge.first), vertex_map_.Rank(edge.second));
+  }
+  graph.SetDomainSizes(sizes);
+  return graph;
+}
+
+void Io::WriteTreeDecomposition(std::ostream& out, const TreeDecomposition& decomposition) const {
+  // The decomposition renumbered to the vertices 0..n-1 of the input
+  TreeDecomposition input_decomposition;
+  int n = num_vertices_;
+  for (int i = 0; i < decomposition.NumBags(); i++) {
+    std::vector<int> bag;
+    for (int v : decomposition.Bag(i)) {
+      bag.push_back(std::stoi(vertex_map_.Kth(v)) - first_vertex_);
+      assert(bag.back() >= 0);
+      n = std::max(n, bag.back() + 1);
+    }
+    input_decomposition.AddBag(bag);
+  }
+  for (const Edge& edge : decomposition.Edges()) input_decomposition.AddEdge(edge.first, edge.second);
+  input_decomposition.AddMissingVertices(n);
+  out<<"s td "<<input_decomposition.NumBags()<<" "<<input_decomposition.Width() + 1<<" "<<n<<"\n";
+  for (int i = 0; i < input_decomposition.NumBags(); i++) {
+    out<<"b "<<i + 1;
+    for (int v : input_decomposition.Bag(i)) out<<" "<<v + 1;
+    out<<"\n";
+  }
+  for (const Edge& edge : input_decomposition.Edges()) {
+    out<<edge.first + 1<<" "<<edge.second + 1<<"\n";
+  }
+}
+
 HyperGraph Io::ReadHyperGraph(std::istream& in) {
   std::vector<std::string> vertices;
   std::vector<std::vector<std::string> > edges;
@@ -4,9 +4,11 @@
 #include <string>
 #include <istream>
 #include <map>
+#include <ostream>
 
 #include "graph.hpp"
 #include "hypergraph.hpp"
+#include "tree_decomposition.hpp"
 #include "utils.hpp"
 
 namespace triangulator {
@@ -15,10 +17,19 @@ namespace triangulator {
 
 class Io {
 public:
+  // Reads a graph in the DIMACS format or the network of a UAI model. DIMACS files can give the domain sizes of
+  // vertices on lines "n <vertex> <size>".
   Graph ReadGraph(std::istream& in);
   HyperGraph ReadHyperGraph(std::istream& in);
+  // Writes a tree decomposition of the last graph read in the PACE .td format. The vertices are numbered 1..n as in
+  // the PACE format, n is the number of vertices of the input and those without edges get bags of their own.
+  void WriteTreeDecomposition(std::ostream& out, const TreeDecomposition& decomposition) const;
 private:
   bool dimacs_;
+  // The number of vertices given by the input and the number of its first vertex: 1 in the PACE format "p tw n m",
+  // and 0 in the format "p n m" and in UAI
+  int num_vertices_ = 0, first_vertex_ = 0;
+  Graph ReadUai(std::istream& in);
   StaticSet<std::string> vertex_map_;
 };
 } // namespace triangulator
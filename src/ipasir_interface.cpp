@@ -79,6 +79,21 @@ bool IpasirInterface::SolutionValue(Lit lit) {
     return !solution_value;
   }
 }
+void IpasirInterface::GetModel(const Lit* lits, int num_lits, Bitset& values) {
+  assert(state_ == State::kSat);
+  values.Resize(num_lits);
+  for (int i = 0; i < num_lits; i++) {
+    if (!lits[i].IsDef() || lits[i].IsFalse()) continue;
+    if (lits[i].IsTrue()) {
+      values.Set(i);
+      continue;
+    }
+    int lit_value = LitValue(lits[i]);
+    assert(abs(lit_value) <= num_vars_);
+    bool solution_value = (ipasir_val(solver_, abs(lit_value)) == abs(lit_value));
+    if (solution_value == (lit_value > 0)) values.Set(i);
+  }
+}
 void IpasirInterface::FreezeVar(Lit var) {
   
 }
@@ -79,6 +79,20 @@ bool MapleGlucoseInterface::SolutionValue(Lit lit) {
     return !solution_value;
   }
 }
+void MapleGlucoseInterface::GetModel(const Lit* lits, int num_lits, Bitset& values) {
+  values.Resize(num_lits);
+  for (int i = 0; i < num_lits; i++) {
+    if (!lits[i].IsDef() || lits[i].IsFalse()) continue;
+    if (lits[i].IsTrue()) {
+      values.Set(i);
+      continue;
+    }
+    int lit_value = LitValue(lits[i]);
+    assert(abs(lit_value) <= glucose_vars_.size());
+    bool solution_value = (MapleGlucose::toInt(glucose_->modelValue(glucose_vars_[abs(lit_value) - 1])) == 1);
+    if (solution_value == (lit_value > 0)) values.Set(i);
+  }
+}
 void MapleGlucoseInterface::FreezeVar(Lit var) {
   if (!preprocess_) return;
   int var_val = abs(LitValue(var));
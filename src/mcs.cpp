@@ -5,6 +5,7 @@
 
 #include "utils.hpp"
 #include "graph.hpp"
+#include "tree_decomposition.hpp"
 
 namespace triangulator {
 namespace mcs {
@@ -167,5 +168,38 @@ int Treewidth(const Graph& graph) {
   return treewidth;
 }
 
+// The parent of the bag of x is the bag of the first eliminated later neighbor, which contains the other later
+// neighbors since they form a clique. The roots of the components are chained together.
+TreeDecomposition ChordalDecomposition(const Graph& graph) {
+  std::vector<int> order = Mcs(graph);
+  std::vector<int> inv_order = utils::PermInverse(order);
+  TreeDecomposition decomposition;
+  std::vector<int> bag_of(graph.n(), -1);
+  std::vector<int> parent(graph.n(), -1);
+  for (int i = 0; i < graph.n(); i++) {
+    int x = order[i];
+    if (graph.Neighbors(x).empty()) continue;
+    std::vector<int> bag = {x};
+    for (int nx : graph.Neighbors(x)) {
+      if (inv_order[nx] > i) {
+        bag.push_back(nx);
+        if (parent[i] == -1 || inv_order[nx] < parent[i]) parent[i] = inv_order[nx];
+      }
+    }
+    bag_of[i] = decomposition.AddBag(bag);
+  }
+  int last_root = -1;
+  for (int i = 0; i < graph.n(); i++) {
+    if (bag_of[i] == -1) continue;
+    if (parent[i] != -1) {
+      decomposition.AddEdge(bag_of[i], bag_of[parent[i]]);
+    } else {
+      if (last_root != -1) decomposition.AddEdge(last_root, bag_of[i]);
+      last_root = bag_of[i];
+    }
+  }
+  return decomposition;
+}
+
 } // namespace mcs
 } // namespace triangulator
@@ -3,6 +3,7 @@
 #include <vector>
 
 #include "graph.hpp"
+#include "tree_decomposition.hpp"
 
 namespace triangulator {
 namespace mcs {
@@ -27,6 +28,10 @@ std::vector<Graph> Atoms(const Graph& graph, const McsMOutput& mcs_m_output);
 // Returns the treewidth of a chordal graph in O(n + m)
 int Treewidth(const Graph& graph);
 
+// Returns a tree decomposition of a chordal graph with a bag for each vertex and its later neighbors in a perfect
+// elimination order, in O(n + m). Vertices without neighbors are not in any bag.
+TreeDecomposition ChordalDecomposition(const Graph& graph);
+
 // [1] Anne Berry, Jean R. S. Blair, Pinar Heggernes, and Barry W. Peyton. Maximum Cardinality Search for Computing Minimal Triangulations of Graphs. Algorithmica 39, (2004), 287-298
 // [2] Robert E. Tarjan. Decomposition by clique separators. Discrete Mathematics 55, (1985), 221-232
 
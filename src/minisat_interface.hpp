@@ -12,6 +12,7 @@ public:
   Lit NewVar() final;
   void AddClause(std::vector<Lit> clause) final;
   bool SolutionValue(Lit lit) final;
+  void GetModel(const Lit* lits, int num_lits, Bitset& values) final;
   bool Solve(std::vector<Lit> assumptions, bool allow_simp) final;
   void FreezeVar(Lit var) final;
   MinisatInterface(bool preprocess);
@@ -0,0 +1,49 @@
+#include "pmc_store.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <cassert>
+
+namespace triangulator {
+
+void PmcStore::Clear() {
+  vertices_.clear();
+  offsets_.assign(1, 0);
+}
+
+void PmcStore::Release() {
+  std::vector<int>().swap(vertices_);
+  std::vector<size_t>(1, 0).swap(offsets_);
+}
+
+// The sets are ordered lexicographically like a sorted std::vector<std::vector<int> >, so the order of the PMCs
+// does not change from that of the vector version
+void PmcStore::SortAndDedup() {
+  for (int i = 0; i < Size(); i++) {
+    std::sort(vertices_.begin() + offsets_[i], vertices_.begin() + offsets_[i + 1]);
+  }
+  std::vector<int> order(Size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](int a, int b) {
+    VertexSpan sa = (*this)[a];
+    VertexSpan sb = (*this)[b];
+    return std::lexicographical_compare(sa.begin(), sa.end(), sb.begin(), sb.end());
+  });
+  PmcStore sorted;
+  sorted.vertices_.reserve(vertices_.size());
+  sorted.offsets_.reserve(offsets_.size());
+  for (int i = 0; i < (int)order.size(); i++) {
+    VertexSpan set = (*this)[order[i]];
+    if (i > 0) {
+      VertexSpan prev = (*this)[order[i - 1]];
+      if (set.size() == prev.size() && std::equal(set.begin(), set.end(), prev.begin())) continue;
+    }
+    sorted.Add(set);
+  }
+  sorted.vertices_.shrink_to_fit();
+  sorted.offsets_.shrink_to_fit();
+  std::swap(vertices_, sorted.vertices_);
+  std::swap(offsets_, sorted.offsets_);
+}
+} // namespace triangulator
@@ -0,0 +1,114 @@
+#pragma once
+
+// Compact storage of many vertex sets, e.g., the PMCs of a graph.
+// The sets are stored back to back in one array, so a set costs its vertices and one offset instead of a heap
+// allocation, and sorting and deduplication move offsets instead of vectors.
+
+#include <vector>
+#include <cstddef>
+#include <cassert>
+
+namespace triangulator {
+// Interface
+
+// Read-only view of a vertex set stored elsewhere. Valid until the storage is modified.
+class VertexSpan {
+public:
+  VertexSpan(const int* begin, const int* end);
+  VertexSpan(const std::vector<int>& vs);
+  const int* begin() const;
+  const int* end() const;
+  int size() const;
+  bool empty() const;
+  int operator[](int i) const;
+  std::vector<int> ToVector() const;
+private:
+  const int* begin_;
+  const int* end_;
+};
+
+class PmcStore {
+public:
+  PmcStore();
+  int Size() const;
+  bool Empty() const;
+  VertexSpan operator[](int i) const;
+
+  void Add(VertexSpan vs);
+  // Appends v to the last set
+  void AddVertex(int v);
+  void RemoveLast();
+  void Clear();
+  // Releases the memory of the store
+  void Release();
+
+  // Sorts the vertices of each set, then sorts the sets and removes the duplicates
+  void SortAndDedup();
+private:
+  std::vector<int> vertices_;
+  // Set i is vertices_[offsets_[i], offsets_[i+1])
+  std::vector<size_t> offsets_;
+};
+
+
+// Implementation
+inline VertexSpan::VertexSpan(const int* begin, const int* end) : begin_(begin), end_(end) { }
+
+inline VertexSpan::VertexSpan(const std::vector<int>& vs) : begin_(vs.data()), end_(vs.data() + vs.size()) { }
+
+inline const int* VertexSpan::begin() const {
+  return begin_;
+}
+
+inline const int* VertexSpan::end() const {
+  return end_;
+}
+
+inline int VertexSpan::size() const {
+  return end_ - begin_;
+}
+
+inline bool VertexSpan::empty() const {
+  return begin_ == end_;
+}
+
+inline int VertexSpan::operator[](int i) const {
+  return begin_[i];
+}
+
+inline std::vector<int> VertexSpan::ToVector() const {
+  return std::vector<int>(begin_, end_);
+}
+
+inline PmcStore::PmcStore() : offsets_(1, 0) { }
+
+inline int PmcStore::Size() const {
+  return offsets_.size() - 1;
+}
+
+inline bool PmcStore::Empty() const {
+  return offsets_.size() == 1;
+}
+
+inline VertexSpan PmcStore::operator[](int i) const {
+  assert(i >= 0 && i < Size());
+  return VertexSpan(vertices_.data() + offsets_[i], vertices_.data() + offsets_[i + 1]);
+}
+
+inline void PmcStore::Add(VertexSpan vs) {
+  vertices_.insert(vertices_.end(), vs.begin(), vs.end());
+  offsets_.push_back(vertices_.size());
+}
+
+inline void PmcStore::AddVertex(int v) {
+  assert(!Empty());
+  vertices_.push_back(v);
+  offsets_.back()++;
+}
+
+inline void PmcStore::RemoveLast() {
+  assert(!Empty());
+  offsets_.pop_back();
+  vertices_.resize(offsets_.back());
+}
+} // namespace triangulator
@@ -5,6 +5,8 @@
 #include <limits>
 #include <vector>
 
+#include "bitset.hpp"
+
 namespace triangulator {
 
 class Lit {
@@ -36,6 +38,9 @@ public:
   virtual Lit NewVar() = 0;
   virtual void AddClause(std::vector<Lit> clause) = 0;
   virtual bool SolutionValue(Lit lit) = 0;
+  // Stores the values of lits[0..num_lits-1] in the last solution to values, resized to num_lits, without a virtual
+  // call per literal. Literals that are not defined read as false.
+  virtual void GetModel(const Lit* lits, int num_lits, Bitset& values) = 0;
   virtual bool Solve(std::vector<Lit> assumptions, bool allow_simp) = 0;
   virtual void FreezeVar(Lit lit) = 0;
   virtual void PrintStats(int lvl) = 0;
@@ -12,6 +12,7 @@
 #include "io.hpp"
 #include "treewidthpreprocessor.hpp"
 #include "bt_algorithm.hpp"
+#include "external_bt_algorithm.hpp"
 #include "fixed_size_enumerator.hpp"
 #include "fixed_size_hyper_enumerator.hpp"
 #include "cardinality_constraint_builder.hpp"
@@ -22,6 +23,7 @@
 #include "setcover.hpp"
 #include "glucose_interface.hpp"
 #include "mapleglucose_interface.hpp"
+#include "mcs.hpp"
 
 namespace triangulator {
 
@@ -45,9 +47,79 @@ std::shared_ptr<SatInterface> SatSolver(const std::string& name) {
     assert(false);
   }
 }
+
+// The atoms of the connected components of the graph that have edges, with the domain sizes of their vertices
+std::vector<Graph> ComponentAtoms(const Graph& graph) {
+  std::vector<Graph> atoms;
+  for (const auto& component : graph.Components({})) {
+    Graph component_graph(graph.EdgesIn(component));
+    if (component_graph.n() == 0) continue;
+    std::vector<Graph> component_atoms = mcs::Atoms(component_graph, mcs::McsM(component_graph));
+    for (auto& atom : component_atoms) {
+      atom.InheritMap(component_graph);
+      std::vector<int> domain_sizes(atom.n());
+      for (int v = 0; v < atom.n(); v++) domain_sizes[v] = graph.DomainSize(atom.MapBack(v));
+      atom.SetDomainSizes(domain_sizes);
+      atoms.push_back(std::move(atom));
+    }
+  }
+  return atoms;
+}
+
+// Solves each atom with solve_atom and combines their costs. A vertex without edges is a bag of its own.
+template<typename CostPolicy, typename SolveAtom>
+typename CostPolicy::Cost SolveAtoms(const Graph& graph, const SolveAtom& solve_atom) {
+  Timer pp_timer;
+  pp_timer.start();
+  std::vector<Graph> atoms = ComponentAtoms(graph);
+  pp_timer.stop();
+  Log::Write(3, "i pp_time ", pp_timer.getTime().count());
+  // The costs are non-negative and 0 is the identity of MergeCost
+  typename CostPolicy::Cost cost = 0;
+  for (int v = 0; v < graph.n(); v++) {
+    if (graph.Neighbors(v).empty()) cost = CostPolicy::MergeCost(cost, graph.DomainSize(v));
+  }
+  for (int i = 0; i < (int)atoms.size(); i++) {
+    SharedGraph atom_graph = std::make_shared<Graph>(std::move(atoms[i]));
+    Log::Write(3, "i pp_size ", atom_graph->n(), " ", atom_graph->m());
+    typename CostPolicy::Cost atom_cost = solve_atom(atom_graph);
+    assert(atom_cost >= 0);
+    cost = CostPolicy::MergeCost(cost, atom_cost);
+  }
+  return cost;
+}
+
+// The weight of a vertex is floor(log2(domain size)), so a bag with table size below 2^(k+1) has weight at most k
+template<typename CostPolicy>
+long long TableSizeSatAtom(SharedGraph graph, int minsep_enconding, int card_encoding, const std::string& solver) {
+  std::vector<int> weights(graph->n());
+  for (int v = 0; v < graph->n(); v++) {
+    for (int d = graph->DomainSize(v); d > 1; d /= 2) weights[v]++;
+  }
+  BtAlgorithm<CostPolicy> bt(graph);
+  FixedSizeEnumerator e(graph, SatSolver(solver), minsep_enconding, card_encoding, weights);
+  for (int k = 0; k <= e.MaxSize(); k++) {
+    auto pmcs = e.AllPmcs(k);
+    Log::Write(3, "i pmcs ", k, " ", pmcs.size());
+    bt.AddPmcs(pmcs);
+    // Every triangulation with cost below 2^(k+1) has all of its PMCs enumerated by now
+    long long bound = (k + 1 >= 62) ? (1LL << 62) : (1LL << (k + 1)) - 1;
+    if (bt.Feasible(bound)) break;
+  }
+  return bt.Solve().first;
+}
+
+template<typename CostPolicy>
+long long TableSizeCombAtom(SharedGraph graph) {
+  auto pmcs = comb_enumerator::Pmcs(*graph);
+  Log::Write(3, "i pmcs ", pmcs.Size());
+  BtAlgorithm<CostPolicy> bt(graph);
+  bt.AddPmcs(pmcs);
+  return bt.Solve().first;
+}
 } // namespace
 
-int TreewidthSat(const Graph& graph, int minsep_enconding, int card_encoding, const std::string& solver, bool pp) {
+int TreewidthSat(const Graph& graph, int minsep_enconding, int card_encoding, const std::string& solver, bool pp, TreeDecomposition* decomposition) {
   Log::Write(3, "i solver_param tw sat ", minsep_enconding, " ", solver);
   Log::Write(3, "i graph_size ", graph.n(), " ", graph.m());
   Timer pp_timer;
@@ -60,12 +132,12 @@ int TreewidthSat(const Graph& graph, int minsep_enconding, int card_encoding, co
   Timer sat_timer;
   Timer bt_timer;
   for (const auto& instance : instances) {
-    Log::Write(3, "i pp_size ", instance.graph.n(), " ", instance.graph.m());
-    std::vector<std::vector<int> > apmcs;
+    Log::Write(3, "i pp_size ", instance.graph->n(), " ", instance.graph->m());
+    BtAlgorithm<TreewidthCost> bt(instance.graph);
     sat_timer.start();
     FixedSizeEnumerator e(instance.graph, SatSolver(solver), minsep_enconding, card_encoding);
     sat_timer.stop();
-    for (int k = 1; k <= instance.graph.n(); k++) {
+    for (int k = 1; k <= instance.graph->n(); k++) {
       sat_timer.start();
       auto pmcs = e.AllPmcs(k);
       sat_timer.stop();
@@ -73,15 +145,18 @@ int TreewidthSat(const Graph& graph, int minsep_enconding, int card_encoding, co
       Log::Write(3, "i minseps ", k, " ", e.Stats().MinsepsFound());
       Log::Write(3, "i satcalls ", k, " ", e.Stats().SatCalls());
       for (const auto& pmc : pmcs) {
-        assert(pmc.size() == k);
-        apmcs.push_back(pmc);
+        assert(pmc.vertices.size() == k);
       }
       bt_timer.start();
-      BtAlgorithm bt;
-      auto sol_b = bt.Solve(instance.graph, apmcs);
+      bt.AddPmcs(pmcs);
+      // The PMCs have at most k vertices, so the bound prunes nothing and only the reconstruction is skipped
+      bool feasible = bt.Feasible(k-1);
       bt_timer.stop();
-      auto solution = TreewidthSolution{sol_b.second, sol_b.first};
-      if (solution.treewidth >= 0) {
+      if (feasible) {
+        bt_timer.start();
+        auto sol_b = bt.Solve();
+        bt_timer.stop();
+        auto solution = TreewidthSolution{sol_b.second, sol_b.first, bt.Decomposition()};
         assert(solution.treewidth == k-1);
         solutions.push_back(solution);
         break;
@@ -91,10 +166,11 @@ int TreewidthSat(const Graph& graph, int minsep_enconding, int card_encoding, co
   Log::Write(3, "i sat_time ", sat_timer.getTime().count());
   Log::Write(3, "i bt_time ", bt_timer.getTime().count());
   auto solution = twpp.MapBack(solutions);
+  if (decomposition) *decomposition = solution.decomposition;
   return solution.treewidth;
 }
 
-int TreewidthAsp(const Graph& graph, bool pp) {
+int TreewidthAsp(const Graph& graph, bool pp, TreeDecomposition* decomposition) {
   Log::Write(3, "i solver_param tw asp ");
   Log::Write(3, "i graph_size ", graph.n(), " ", graph.m());
   Timer pp_timer;
@@ -107,23 +183,26 @@ int TreewidthAsp(const Graph& graph, bool pp) {
   Timer asp_timer;
   Timer bt_timer;
   for (const auto& instance : instances) {
-    Log::Write(3, "i pp_size ", instance.graph.n(), " ", instance.graph.m());
-    std::vector<std::vector<int>> apmcs;
-    for (int k = 1; k <= instance.graph.n(); k++) {
+    Log::Write(3, "i pp_size ", instance.graph->n(), " ", instance.graph->m());
+    BtAlgorithm<TreewidthCost> bt(instance.graph);
+    for (int k = 1; k <= instance.graph->n(); k++) {
       asp_timer.start();
-      auto pmcs = asp_enumerator::TreewidthPmcs(instance.graph, k);
+      auto pmcs = asp_enumerator::TreewidthPmcs(*instance.graph, k);
       asp_timer.stop();
-      Log::Write(3, "i pmcs ", k, " ", pmcs.size());
-      for (const auto& pmc : pmcs) {
-        assert(pmc.size() == k);
-        apmcs.push_back(pmc);
+      Log::Write(3, "i pmcs ", k, " ", pmcs.Size());
+      for (int i = 0; i < pmcs.Size(); i++) {
+        assert(pmcs[i].size() == k);
       }
       bt_timer.start();
-      BtAlgorithm bt;
-      auto sol_b = bt.Solve(instance.graph, apmcs);
+      bt.AddPmcs(pmcs);
+      // The PMCs have at most k vertices, so the bound prunes nothing and only the reconstruction is skipped
+      bool feasible = bt.Feasible(k-1);
       bt_timer.stop();
-      auto solution = TreewidthSolution{sol_b.second, sol_b.first};
-      if (solution.treewidth >= 0) {
+      if (feasible) {
+        bt_timer.start();
+        auto sol_b = bt.Solve();
+        bt_timer.stop();
+        auto solution = TreewidthSolution{sol_b.second, sol_b.first, bt.Decomposition()};
         assert(solution.treewidth == k-1);
         solutions.push_back(solution);
         break;
@@ -133,10 +212,11 @@ int TreewidthAsp(const Graph& graph, bool pp) {
   Log::Write(3, "i asp_time ", asp_timer.getTime().count());
   Log::Write(3, "i bt_time ", bt_timer.getTime().count());
   auto solution = twpp.MapBack(solutions);
+  if (decomposition) *decomposition = solution.decomposition;
   return solution.treewidth;
 }
 
-int TreewidthComb(const Graph& graph, bool pp) {
+int TreewidthComb(const Graph& graph, bool pp, TreeDecomposition* decomposition) {
   Log::Write(3, "i solver_param tw comb");
   Log::Write(3, "i graph_size ", graph.n(), " ", graph.m());
   Timer pp_timer;
@@ -149,24 +229,91 @@ int TreewidthComb(const Graph& graph, bool pp) {
   Timer enum_timer;
   Timer bt_timer;
   for (const auto& instance : instances) {
-    Log::Write(3, "i pp_size ", instance.graph.n(), " ", instance.graph.m());
+    Log::Write(3, "i pp_size ", instance.graph->n(), " ", instance.graph->m());
     enum_timer.start();
-    auto pmcs = comb_enumerator::Pmcs(instance.graph);
+    auto pmcs = comb_enumerator::Pmcs(*instance.graph);
     enum_timer.stop();
-    Log::Write(3, "i pmcs ", pmcs.size());
+    Log::Write(3, "i pmcs ", pmcs.Size());
     bt_timer.start();
-    BtAlgorithm bt;
-    auto sol_b = bt.Solve(instance.graph, pmcs);
+    std::pair<int, std::vector<Edge> > sol_b;
+    TreeDecomposition bt_decomposition;
+    if (ExternalBtAlgorithmBase::RunBytes() > 0) {
+      ExternalBtAlgorithm<TreewidthCost> bt(instance.graph, ExternalBtAlgorithmBase::RunBytes());
+      bt.AddPmcs(pmcs);
+      pmcs.Release();
+      sol_b = bt.Solve();
+      bt_decomposition = bt.Decomposition();
+    } else {
+      BtAlgorithm<TreewidthCost> bt(instance.graph);
+      bt.AddPmcs(pmcs);
+      sol_b = bt.Solve();
+      bt_decomposition = bt.Decomposition();
+    }
     bt_timer.stop();
-    auto solution = TreewidthSolution{sol_b.second, sol_b.first};
+    auto solution = TreewidthSolution{sol_b.second, sol_b.first, bt_decomposition};
     solutions.push_back(solution);
   }
   Log::Write(3, "i enum_time ", enum_timer.getTime().count());
   Log::Write(3, "i bt_time ", bt_timer.getTime().count());
   auto solution = twpp.MapBack(solutions);
+  if (decomposition) *decomposition = solution.decomposition;
   return solution.treewidth;
 }
 
+// Decomposing by clique minimal separators preserves the minimum fill-in, so the atoms are solved independently
+long long MinimumFillInComb(const Graph& graph) {
+  Log::Write(3, "i solver_param fillin comb");
+  Log::Write(3, "i graph_size ", graph.n(), " ", graph.m());
+  Timer pp_timer;
+  pp_timer.start();
+  std::vector<Graph> atoms = ComponentAtoms(graph);
+  pp_timer.stop();
+  Log::Write(3, "i pp_time ", pp_timer.getTime().count());
+  long long fill_in = 0;
+  Timer enum_timer;
+  Timer bt_timer;
+  for (auto& atom : atoms) {
+    SharedGraph atom_graph = std::make_shared<Graph>(std::move(atom));
+    Log::Write(3, "i pp_size ", atom_graph->n(), " ", atom_graph->m());
+    enum_timer.start();
+    auto pmcs = comb_enumerator::Pmcs(*atom_graph);
+    enum_timer.stop();
+    Log::Write(3, "i pmcs ", pmcs.Size());
+    bt_timer.start();
+    BtAlgorithm<FillInCost> bt(atom_graph);
+    bt.AddPmcs(pmcs);
+    auto sol_b = bt.Solve();
+    bt_timer.stop();
+    assert(sol_b.first >= 0 && sol_b.first == (long long)sol_b.second.size());
+    fill_in += sol_b.first;
+  }
+  Log::Write(3, "i enum_time ", enum_timer.getTime().count());
+  Log::Write(3, "i bt_time ", bt_timer.getTime().count());
+  return fill_in;
+}
+
+// Decomposing by clique minimal separators preserves both the largest and the total table size. The treewidth
+// preprocessing rules are not used since they do not hold with domain sizes.
+long long TableSizeSat(const Graph& graph, bool total, int minsep_enconding, int card_encoding, const std::string& solver) {
+  Log::Write(3, "i solver_param tablesize sat ", total ? "total " : "max ", minsep_enconding, " ", solver);
+  Log::Write(3, "i graph_size ", graph.n(), " ", graph.m());
+  if (total) {
+    return SolveAtoms<TableSizeCost>(graph, [&](SharedGraph atom) {
+      return TableSizeSatAtom<TableSizeCost>(atom, minsep_enconding, card_encoding, solver);
+    });
+  }
+  return SolveAtoms<MaxTableSizeCost>(graph, [&](SharedGraph atom) {
+    return TableSizeSatAtom<MaxTableSizeCost>(atom, minsep_enconding, card_encoding, solver);
+  });
+}
+
+long long TableSizeComb(const Graph& graph, bool total) {
+  Log::Write(3, "i solver_param tablesize comb ", total ? "total" : "max");
+  Log::Write(3, "i graph_size ", graph.n(), " ", graph.m());
+  if (total) return SolveAtoms<TableSizeCost>(graph, TableSizeCombAtom<TableSizeCost>);
+  return SolveAtoms<MaxTableSizeCost>(graph, TableSizeCombAtom<MaxTableSizeCost>);
+}
+
 int HypertreewidthSat(const HyperGraph& hypergraph, int minsep_enconding, int card_encoding, const std::string& solver) {
   Log::Write(3, "i solver_param ghtw sat ", minsep_enconding, " ", solver);
   Log::Write(3, "i graph_size ", hypergraph.n(), " ", hypergraph.m(), " ", hypergraph.PrimalGraph().m());
@@ -181,7 +328,7 @@ int HypertreewidthSat(const HyperGraph& hypergraph, int minsep_enconding, int ca
   Timer bt_timer;
   for (const auto& instance : instances) {
     Log::Write(3, "i pp_size ", instance.n(), " ", instance.m(), " ", instance.PrimalGraph().m());
-    std::vector<std::vector<int>> apmcs;
+    BtAlgorithm<TreewidthCost> bt(instance.SharedPrimalGraph());
     sat_timer.start();
     FixedSizeHyperEnumerator e(instance, SatSolver(solver), minsep_enconding, card_encoding);
     sat_timer.stop();
@@ -192,14 +339,12 @@ int HypertreewidthSat(const HyperGraph& hypergraph, int minsep_enconding, int ca
       Log::Write(3, "i pmcs ", k, " ", pmcs.size());
       Log::Write(3, "i minseps ", k, " ", e.Stats().MinsepsFound());
       Log::Write(3, "i satcalls ", k, " ", e.Stats().SatCalls());
-      for (const auto& pmc : pmcs) {
-        apmcs.push_back(pmc);
-      }
       bt_timer.start();
-      BtAlgorithm bt;
-      auto sol_b = bt.Solve(instance.PrimalGraph(), apmcs);
+      bt.AddPmcs(pmcs);
+      // Only the existence of a triangulation matters and all of them have width below n, so nothing is pruned
+      bool feasible = bt.Feasible(instance.n());
       bt_timer.stop();
-      if (sol_b.first >= 0) {
+      if (feasible) {
         solution = std::max(solution, k);
         break;
       }
@@ -228,12 +373,13 @@ int HypertreewidthAsp(const HyperGraph& hypergraph) {
       asp_timer.start();
       auto pmcs = asp_enumerator::HypertreewidthPmcs(instance, k);
       asp_timer.stop();
-      Log::Write(3, "i pmcs ", k, " ", pmcs.size());
+      Log::Write(3, "i pmcs ", k, " ", pmcs.Size());
       bt_timer.start();
-      BtAlgorithm bt;
-      auto sol_b = bt.Solve(instance.PrimalGraph(), pmcs);
+      BtAlgorithm<TreewidthCost> bt(instance.SharedPrimalGraph());
+      bt.AddPmcs(pmcs);
+      bool feasible = bt.Feasible(instance.n());
       bt_timer.stop();
-      if (sol_b.first >= 0) {
+      if (feasible) {
         solution = std::max(solution, k);
         break;
       }
@@ -262,32 +408,32 @@ int HypertreewidthComb(const HyperGraph& hypergraph) {
     enum_timer.start();
     auto pmcs = comb_enumerator::Pmcs(instance.PrimalGraph());
     enum_timer.stop();
-    Log::Write(3, "i pmcs ", pmcs.size());
+    Log::Write(3, "i pmcs ", pmcs.Size());
     sc_timer.start();
     Setcover sc(instance.Edges());
     sc_timer.stop();
-    std::vector<char> can(pmcs.size());
+    std::vector<char> can(pmcs.Size());
+    BtAlgorithm<TreewidthCost> bt(instance.SharedPrimalGraph());
     for (int k = 1; k <= instance.n(); k++) {
-      std::vector<std::vector<int>> tpmcs;
-      for (int i = 0; i < (int)pmcs.size(); i++) {
-        if (can[i]) {
-          tpmcs.push_back(pmcs[i]);
-        } else {
+      // The PMCs that became coverable with k edges
+      PmcStore tpmcs;
+      for (int i = 0; i < pmcs.Size(); i++) {
+        if (!can[i]) {
           sc_timer.start();
-          auto sol = sc.Solve(pmcs[i], k, k);
+          auto sol = sc.Solve(pmcs[i].ToVector(), k, k);
           sc_timer.stop();
           if (sol[0] != -1) {
             assert((int)sol.size() == k);
-            tpmcs.push_back(pmcs[i]);
+            tpmcs.Add(pmcs[i]);
             can[i] = true;
           }
         }
       }
       bt_timer.start();
-      BtAlgorithm bt;
-      auto sol_b = bt.Solve(instance.PrimalGraph(), tpmcs);
+      bt.AddPmcs(tpmcs);
+      bool feasible = bt.Feasible(instance.n());
       bt_timer.stop();
-      if (sol_b.first >= 0) {
+      if (feasible) {
         solution = std::max(solution, k);
         break;
       }
@@ -310,7 +456,7 @@ int CountMinseps(const Graph& graph, int ub) {
   Log::Write(3, "i pp_time ", pp_timer.getTime().count());
   int ans = 0;
   for (const auto& instance : instances) {
-    ans += (int)comb_enumerator::FindMinSeps(instance.graph, ub).size();
+    ans += (int)comb_enumerator::FindMinSeps(*instance.graph, ub).size();
     if (ans > ub) break;
   }
   return std::min(ans, ub);
@@ -2,12 +2,21 @@
 
 #include "graph.hpp"
 #include "hypergraph.hpp"
+#include "tree_decomposition.hpp"
 
 namespace triangulator {
 
-int TreewidthSat(const Graph& graph, int minsep_enconding, int card_encoding, const std::string& solver, bool pp);
-int TreewidthAsp(const Graph& graph, bool pp);
-int TreewidthComb(const Graph& graph, bool pp);
+// The treewidth solvers return the treewidth and store an optimal tree decomposition in decomposition if it is given
+int TreewidthSat(const Graph& graph, int minsep_enconding, int card_encoding, const std::string& solver, bool pp, TreeDecomposition* decomposition = nullptr);
+int TreewidthAsp(const Graph& graph, bool pp, TreeDecomposition* decomposition = nullptr);
+int TreewidthComb(const Graph& graph, bool pp, TreeDecomposition* decomposition = nullptr);
+
+long long MinimumFillInComb(const Graph& graph);
+
+// Minimum largest table size, or minimum total table size if total, of a junction tree over the graph with the
+// domain sizes of its vertices
+long long TableSizeSat(const Graph& graph, bool total, int minsep_enconding, int card_encoding, const std::string& solver);
+long long TableSizeComb(const Graph& graph, bool total);
 
 int HypertreewidthSat(const HyperGraph& hypergraph, int minsep_enconding, int card_encoding, const std::string& solver);
 int HypertreewidthAsp(const HyperGraph& hypergraph);
@@ -1,22 +1,63 @@
 #include <fstream>
+#include <sstream>
 #include <vector>
+#include <random>
+#include <limits>
+#include <algorithm>
+#include <cassert>
 
 #include "graph.hpp"
 #include "io.hpp"
 #include "hypergraph.hpp"
 #include "solver.hpp"
+#include "enumerator.hpp"
+#include "bt_algorithm.hpp"
+#include "external_bt_algorithm.hpp"
+#include "tree_decomposition.hpp"
 #include "utils.hpp"
 
 namespace triangulator {
 namespace {
   std::vector<std::string> sat_solvers_ = {"minisat", "cryptominisat", "ipasir", "glucose", "mapleglucose", "minisatnopp", "glucosenopp"};
+
+// Minimum fill-in by a DP over the sets of eliminated vertices. The filled graph of an elimination order has an edge
+// from each vertex v to the vertices after it that are reachable from v through the vertices before it, so the fill
+// is the sum of their numbers minus m.
+long long ExhaustiveFillIn(const Graph& graph) {
+  int n = graph.n();
+  assert(n <= 20);
+  std::vector<int> min_edges(1 << n, std::numeric_limits<int>::max());
+  min_edges[0] = 0;
+  for (int eliminated = 0; eliminated < (1 << n); eliminated++) {
+    if (min_edges[eliminated] == std::numeric_limits<int>::max()) continue;
+    for (int v = 0; v < n; v++) {
+      if (eliminated & (1 << v)) continue;
+      int visited = 1 << v;
+      int later = 0;
+      std::vector<int> stack = {v};
+      while (!stack.empty()) {
+        int u = stack.back();
+        stack.pop_back();
+        for (int w : graph.Neighbors(u)) {
+          if (visited & (1 << w)) continue;
+          visited |= 1 << w;
+          if (eliminated & (1 << w)) stack.push_back(w);
+          else later++;
+        }
+      }
+      int next = eliminated | (1 << v);
+      min_edges[next] = std::min(min_edges[next], min_edges[eliminated] + later);
+    }
+  }
+  return min_edges[(1 << n) - 1] - graph.m();
+}
 }
 
 void testHyperGraph(std::string filename, int ghtw) {
   Io io;
   std::ifstream input("hyper_instances/"+filename);
   const HyperGraph hypergraph = io.ReadHyperGraph(input);
-  for (int i = 0; i < 6; i++) {
+  for (int i = 0; i < 9; i++) {
     for (int j = 0; j < 2; j++) {
       for (std::string solver : sat_solvers_) {
         int sat_ghtw = HypertreewidthSat(hypergraph, i, j, solver);
@@ -41,7 +82,7 @@ void testGraph(std::string filename, int tw) {
   Io io;
   std::ifstream input("instances/"+filename);
   const Graph graph = io.ReadGraph(input);
-  for (int i = 0; i < 6; i++) {
+  for (int i = 0; i < 9; i++) {
     for (int j = 0; j < 2; j++) {
       for (std::string solver : sat_solvers_) {
         int sat_tw = TreewidthSat(graph, i, j, solver, true);
@@ -62,6 +103,249 @@ void testGraph(std::string filename, int tw) {
   Log::Write(2, "Success ", filename, " ", tw);
 }
 
+// Checks the .td output of comb on the graph given as text: the number of vertices and the width in the header, and
+// that every vertex 1..n is in a bag of a tree
+void testTreeDecompositionOutput(std::string graph_text, int n, int tw) {
+  Io io;
+  std::istringstream input(graph_text);
+  const Graph graph = io.ReadGraph(input);
+  TreeDecomposition decomposition;
+  TreewidthComb(graph, true, &decomposition);
+  std::stringstream td;
+  io.WriteTreeDecomposition(td, decomposition);
+  std::string s, t;
+  int num_bags, bag_size, td_n;
+  td>>s>>t>>num_bags>>bag_size>>td_n;
+  if (s != "s" || t != "td" || td_n != n || bag_size != tw + 1) {
+    utils::ErrorDie("Fail td output. Got n ", td_n, " width ", bag_size - 1, " expected ", n, " ", tw);
+  }
+  std::vector<char> covered(n + 1);
+  for (int i = 0; i < num_bags; i++) {
+    std::string line;
+    while (line.empty()) std::getline(td, line);
+    std::istringstream bag(line);
+    int id, v;
+    bag>>s>>id;
+    while (bag>>v) {
+      if (v < 1 || v > n) utils::ErrorDie("Fail td output. Vertex ", v, " out of range");
+      covered[v] = true;
+    }
+  }
+  int num_edges = 0, b1, b2;
+  while (td>>b1>>b2) num_edges++;
+  for (int v = 1; v <= n; v++) {
+    if (!covered[v]) utils::ErrorDie("Fail td output. Vertex ", v, " not in a bag");
+  }
+  if (num_edges != num_bags - 1) utils::ErrorDie("Fail td output. ", num_edges, " edges for ", num_bags, " bags");
+  Log::Write(2, "Success td output ", n, " ", tw);
+}
+
+// Checks the minimum largest and total table size of the graph given as text with comb and the SAT solvers
+void testTableSize(std::string graph_text, int n, long long max_size, long long total_size) {
+  Io io;
+  std::istringstream input(graph_text);
+  const Graph graph = io.ReadGraph(input);
+  if (graph.n() != n) utils::ErrorDie("Fail table size input. Got ", graph.n(), " vertices expected ", n);
+  if (TableSizeComb(graph, false) != max_size || TableSizeComb(graph, true) != total_size) {
+    utils::ErrorDie("Fail table size comb. Got ", TableSizeComb(graph, false), " ", TableSizeComb(graph, true),
+                    " expected ", max_size, " ", total_size);
+  }
+  for (int i = 0; i < 9; i++) {
+    for (std::string solver : sat_solvers_) {
+      long long sat_max = TableSizeSat(graph, false, i, 0, solver);
+      long long sat_total = TableSizeSat(graph, true, i, 0, solver);
+      if (sat_max != max_size || sat_total != total_size) {
+        utils::ErrorDie("Fail table size ", solver, " encoding ", i, ". Got ", sat_max, " ", sat_total, " expected ",
+                        max_size, " ", total_size);
+      }
+    }
+  }
+  Log::Write(2, "Success table size ", max_size, " ", total_size);
+}
+
+void testFillIn(const Graph& graph, std::string name) {
+  long long exhaustive = ExhaustiveFillIn(graph);
+  long long comb = MinimumFillInComb(graph);
+  if (comb != exhaustive) utils::ErrorDie("Fail fill-in ", name, ". Got ", comb, " expected ", exhaustive);
+  Log::Write(2, "Success fill-in ", name, " ", exhaustive);
+}
+
+void testFillIn(std::string filename) {
+  Io io;
+  std::ifstream input("instances/"+filename);
+  testFillIn(io.ReadGraph(input), filename);
+}
+
+// Random graphs with n vertices and edge probability p in percent
+void testFillInRandom(int n, int p, int count) {
+  std::mt19937 gen(n * 100 + p);
+  for (int i = 0; i < count; i++) {
+    Graph graph(n);
+    for (int v = 0; v < n; v++) {
+      for (int u = v + 1; u < n; u++) {
+        if ((int)(gen() % 100) < p) graph.AddEdge(v, u);
+      }
+    }
+    testFillIn(graph, "random " + std::to_string(n) + " " + std::to_string(p) + " " + std::to_string(i));
+  }
+}
+
+// The square of a path with more vertices than Graph::kSparseThreshold, so that the edges are kept in a hash set.
+// It has treewidth 2 and is solved by the preprocessing.
+void testSparseGraph() {
+  const int n = Graph::kSparseThreshold + 100;
+  Graph graph(n);
+  for (int v = 0; v + 1 < n; v++) graph.AddEdge(v, v + 1);
+  for (int v = 0; v + 2 < n; v++) graph.AddEdge(v, v + 2);
+  if (!graph.IsSparse() || graph.m() != 2 * n - 3) utils::ErrorDie("Fail sparse graph construction");
+  if (!graph.HasEdge(n - 1, n - 3) || graph.HasEdge(0, 3) || graph.Neighbors(1).size() != 3) {
+    utils::ErrorDie("Fail sparse graph edges");
+  }
+  graph.AddEdge(0, n - 1);
+  if (!graph.HasEdge(n - 1, 0) || graph.Neighbors(n - 1).size() != 3) utils::ErrorDie("Fail sparse graph AddEdge");
+  graph.RemoveEdge(n - 1, 0);
+  if (graph.HasEdge(0, n - 1) || graph.Neighbors(0).size() != 2 || graph.m() != 2 * n - 3) {
+    utils::ErrorDie("Fail sparse graph RemoveEdge");
+  }
+  // Two consecutive vertices separate the square of a path
+  auto components = graph.Components({1000, 1001});
+  if (components.size() != 2 || components[0].size() + components[1].size() != n - 2 ||
+      std::min(components[0].size(), components[1].size()) != 1000) {
+    utils::ErrorDie("Fail sparse graph components. Got ", components.size(), " components");
+  }
+  if (graph.Components({1000}).size() != 1 || !graph.IsConnectedOrIsolated()) {
+    utils::ErrorDie("Fail sparse graph connectivity");
+  }
+  TreeDecomposition decomposition;
+  int comb_tw = TreewidthComb(graph, true, &decomposition);
+  if (comb_tw != 2 || decomposition.Width() != 2 || !decomposition.IsValid(graph)) {
+    utils::ErrorDie("Fail sparse graph comb. Got ", comb_tw, " expected 2");
+  }
+  Log::Write(2, "Success sparse graph ", n);
+}
+
+// Random graphs with 300 vertices, so that the bit kernels of Graph use Bitset instead of FixedBitset. The edge
+// probability keeps m above n * words / 2, below which Components falls back to traversing the adjacency lists.
+// The kernels are checked against a traversal of the adjacency lists.
+void testBitsetGraph() {
+  const int n = 300;
+  std::mt19937 gen(n);
+  for (int i = 0; i < 10; i++) {
+    Graph graph(n);
+    for (int v = 0; v < n; v++) {
+      for (int u = v + 1; u < n; u++) {
+        if (gen() % 100 < 3) graph.AddEdge(v, u);
+      }
+    }
+    std::vector<int> separator, in_separator(n);
+    for (int v = 0; v < n; v++) {
+      if (gen() % 100 < 60) {
+        separator.push_back(v);
+        in_separator[v] = true;
+      }
+    }
+    std::vector<std::vector<int> > expected;
+    std::vector<int> visited = in_separator;
+    for (int v = 0; v < n; v++) {
+      if (visited[v]) continue;
+      expected.push_back({v});
+      visited[v] = true;
+      for (int j = 0; j < (int)expected.back().size(); j++) {
+        for (int u : graph.Neighbors(expected.back()[j])) {
+          if (!visited[u]) {
+            visited[u] = true;
+            expected.back().push_back(u);
+          }
+        }
+      }
+      std::sort(expected.back().begin(), expected.back().end());
+    }
+    if (graph.Components(separator) != expected) {
+      utils::ErrorDie("Fail bitset graph components ", i, ". Got ", graph.Components(separator).size(), " expected ",
+                      expected.size());
+    }
+    std::vector<int> vs(separator.begin(), separator.begin() + separator.size() / 2);
+    std::vector<int> neighbors;
+    for (int v : vs) {
+      for (int u : graph.Neighbors(v)) {
+        if (!std::binary_search(vs.begin(), vs.end(), u)) neighbors.push_back(u);
+      }
+    }
+    std::sort(neighbors.begin(), neighbors.end());
+    neighbors.erase(std::unique(neighbors.begin(), neighbors.end()), neighbors.end());
+    if (graph.Neighbors(vs) != neighbors) utils::ErrorDie("Fail bitset graph neighbors ", i);
+    // Vertices 0..11 made a clique, which is large enough for IsClique to use the kernel, with and without 12
+    std::vector<int> clique;
+    for (int v = 0; v < 12; v++) {
+      for (int u : clique) {
+        if (!graph.HasEdge(v, u)) graph.AddEdge(v, u);
+      }
+      clique.push_back(v);
+    }
+    if (!graph.IsClique(clique)) utils::ErrorDie("Fail bitset graph clique ", i);
+    clique.push_back(12);
+    bool is_clique = true;
+    for (int v = 0; v < 12; v++) {
+      if (!graph.HasEdge(v, 12)) is_clique = false;
+    }
+    if (graph.IsClique(clique) != is_clique) utils::ErrorDie("Fail bitset graph clique ", i);
+  }
+  Log::Write(2, "Success bitset graph ", n);
+}
+
+// Treewidth and minimum fill-in with comb only, without preprocessing so that BT gets the whole graph
+void testCombThreads(std::string filename, int tw, long long fill_in) {
+  Io io;
+  std::ifstream input("instances/"+filename);
+  const Graph graph = io.ReadGraph(input);
+  TreeDecomposition decomposition;
+  int comb_tw = TreewidthComb(graph, false, &decomposition);
+  if (comb_tw != tw || decomposition.Width() != tw || !decomposition.IsValid(graph)) {
+    utils::ErrorDie("Fail ", filename, " comb threads. Got ", comb_tw, " expected ", tw);
+  }
+  long long comb_fill_in = MinimumFillInComb(graph);
+  if (comb_fill_in != fill_in) {
+    utils::ErrorDie("Fail fill-in ", filename, " comb threads. Got ", comb_fill_in, " expected ", fill_in);
+  }
+  Log::Write(2, "Success threads ", filename, " ", tw, " ", fill_in);
+}
+
+// BT out of core with a run size of run_bytes, with and without preprocessing. The run size is a static setting of
+// ExternalBtAlgorithmBase, so it is reset after.
+void testGraphExternal(std::string filename, int tw, size_t run_bytes) {
+  Io io;
+  std::ifstream input("instances/"+filename);
+  const Graph graph = io.ReadGraph(input);
+  ExternalBtAlgorithmBase::SetRunBytes(run_bytes);
+  for (bool pp : {true, false}) {
+    TreeDecomposition decomposition;
+    int comb_tw = TreewidthComb(graph, pp, &decomposition);
+    if (comb_tw != tw || decomposition.Width() != tw || !decomposition.IsValid(graph)) {
+      utils::ErrorDie("Fail ", filename, " external comb pp ", pp, ". Got ", comb_tw, " expected ", tw);
+    }
+  }
+  ExternalBtAlgorithmBase::SetRunBytes(0);
+  Log::Write(2, "Success external ", filename, " ", tw);
+}
+
+// Runs only the SAT solvers, with the given minsep encodings
+void testGraphSat(std::string filename, int tw, const std::vector<int>& encodings) {
+  Io io;
+  std::ifstream input("instances/"+filename);
+  const Graph graph = io.ReadGraph(input);
+  for (int i : encodings) {
+    for (int j = 0; j < 2; j++) {
+      for (std::string solver : sat_solvers_) {
+        int sat_tw = TreewidthSat(graph, i, j, solver, true);
+        if (sat_tw != tw) {
+          utils::ErrorDie("Fail ", filename, " ", solver, " encoding ", i, ". Got ", sat_tw, " expected ", tw);
+        }
+      }
+    }
+  }
+  Log::Write(2, "Success ", filename, " ", tw);
+}
+
 void runtestsFast() {
   // Runtime of should be <20s.
   Log::SetLogLevel(2);
@@ -73,7 +357,6 @@ void runtestsFast() {
   testGraph("weird6.graph", 2);
   testGraph("weird7.graph", 1);
   testGraph("weird8.graph", 2);
-  testGraph("anna-pp.graph", 12);
   testGraph("alarm.graph", 4);
   testGraph("celar09pp.graph", 7);
   testGraph("child.graph", 3);
@@ -86,25 +369,90 @@ void runtestsFast() {
   testGraph("oesoca.graph", 3);
   testGraph("oesoca+-pp.graph", 11);
   testGraph("oesoca42.graph", 3);
-  testGraph("pace16tw_BlanusaSecondSnarkGraph.graph", 4);
   testGraph("pace16tw_ChvatalGraph.graph", 6);
 
   testHyperGraph("s27.graph", 2);
+
+  // PACE input with isolated vertices 4 and 5, the 0-based format and UAI
+  testTreeDecompositionOutput("p tw 5 2\ne 1 2\ne 2 3\n", 5, 1);
+  testTreeDecompositionOutput("p 4 3\ne 0 1\ne 1 2\ne 2 0\n", 4, 2);
+  testTreeDecompositionOutput("MARKOV\n4\n2 2 2 2\n2\n2 0 1\n2 1 2\n", 4, 1);
+
+  testFillIn("weird8.graph");
+  testFillIn("grid3_3.graph");
+  testFillIn("myciel3.graph");
+  testFillIn("pace16tw_GoldnerHararyGraph.graph");
+
+  // Tables {1,2} and {2,3} of the path
+  testTableSize("p tw 3 2\ne 1 2\ne 2 3\nn 1 2\nn 2 3\nn 3 4\n", 3, 12, 18);
+  // The chord 1-3 of the 4-cycle gives tables 12 and 20, the chord 2-4 gives 30 and 30
+  testTableSize("p tw 4 4\ne 1 2\ne 2 3\ne 3 4\ne 4 1\nn 1 2\nn 2 3\nn 3 2\nn 4 5\n", 4, 20, 32);
+  // The isolated vertex 3 has a table of its own. The vertices without a domain size are binary.
+  testTableSize("p tw 3 1\ne 1 2\nn 2 3\nn 3 7\n", 3, 7, 13);
+  testTableSize("p tw 2 0\nn 1 5\nn 2 3\n", 2, 5, 8);
+  // UAI with the variable 3 in a scope of its own
+  testTableSize("MARKOV\n4\n2 3 4 5\n3\n2 0 1\n2 1 2\n1 3\n", 4, 12, 23);
+
+  testBitsetGraph();
+  testSparseGraph();
+
+  // BT on 3 threads. The thread count is a static setting of BtAlgorithmBase, so it is reset after.
+  BtAlgorithmBase::SetThreads(3);
+  testGraphSat("pace16tw_ChvatalGraph.graph", 6, {0});
+  testFillIn("grid4_4.graph");
+  // Brinkmann has layers wide enough for the DP to be split over the threads
+  testCombThreads("pace16tw_BrinkmannGraph.graph", 8, 59);
+  BtAlgorithmBase::SetThreads(1);
+
+  // Runs of 1KB, so that the triplets are spread over many runs
+  testGraphExternal("grid4_4.graph", 4, 1 << 10);
+  testGraphExternal("myciel3.graph", 5, 1 << 10);
+  testGraphExternal("pace16tw_ChvatalGraph.graph", 6, 1 << 10);
+
+  // The encodings that are seeded with minseps. Seeding is a static setting of Enumerator, so it is reset after.
+  Enumerator::SetSeedMinseps(100);
+  testGraphSat("weird5.graph", 2, {0, 1, 2, 3, 5, 7});
+  Enumerator::SetSeedMinseps(0);
+
+  // The encodings that block bad solutions with minseps, blocking a minsep for each broken component pair too
+  Enumerator::SetMultipleMinseps(true);
+  testGraphSat("weird5.graph", 2, {0, 1, 2, 3, 5, 6, 7});
+  Enumerator::SetMultipleMinseps(false);
 }
 
 void runtestsSlow() {
   // Runtime should be <20min.
   Log::SetLogLevel(2);
   testGraph("anna.graph", 12);
+  testGraph("anna-pp.graph", 12);
   testGraph("barley.graph", 7);
   testGraph("david-pp.graph", 13);
   testGraph("hailfinder.graph", 4);
   testGraph("jean.graph", 9);
   testGraph("mainuk.graph", 7);
   testGraph("pace16tw_AhrensSzekeresGeneralizedQuadrangleGraph_3.graph", 17);
+  testGraph("pace16tw_BlanusaSecondSnarkGraph.graph", 4);
   testGraph("pace16tw_BrinkmannGraph.graph", 8);
   
   testHyperGraph("grid5.graph", 3);
+
+  testFillIn("grid4_4.graph");
+  testFillIn("pace16tw_ChvatalGraph.graph");
+  testFillInRandom(10, 30, 10);
+  testFillInRandom(12, 50, 10);
+  testFillInRandom(14, 20, 5);
+
+  Enumerator::SetSeedMinseps(100);
+  testGraphSat("grid4_4.graph", 4, {0, 1, 2, 3, 5, 7});
+  testGraphSat("myciel3.graph", 5, {0, 1, 2, 3, 5, 7});
+  testGraphSat("pace16tw_ChvatalGraph.graph", 6, {0, 1, 2, 3, 5, 7});
+  Enumerator::SetSeedMinseps(0);
+
+  Enumerator::SetMultipleMinseps(true);
+  testGraphSat("grid4_4.graph", 4, {0, 1, 2, 3, 5, 6, 7});
+  testGraphSat("myciel3.graph", 5, {0, 1, 2, 3, 5, 6, 7});
+  testGraphSat("pace16tw_ChvatalGraph.graph", 6, {0, 1, 2, 3, 5, 6, 7});
+  Enumerator::SetMultipleMinseps(false);
 }
 
 } // namespace triangulator
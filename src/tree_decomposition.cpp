@@ -0,0 +1,141 @@
+#include "tree_decomposition.hpp"
+
+#include <vector>
+#include <queue>
+#include <algorithm>
+#include <cassert>
+
+#include "graph.hpp"
+
+namespace triangulator {
+
+int TreeDecomposition::AddBag(std::vector<int> bag) {
+  std::sort(bag.begin(), bag.end());
+  int id = bags_.size();
+  for (int v : bag) {
+    assert(v >= 0);
+    if (v >= (int)bags_of_.size()) bags_of_.resize(v + 1);
+    bags_of_[v].push_back(id);
+  }
+  bags_.push_back(std::move(bag));
+  return id;
+}
+
+void TreeDecomposition::AddEdge(int bag1, int bag2) {
+  assert(bag1 >= 0 && bag1 < NumBags() && bag2 >= 0 && bag2 < NumBags() && bag1 != bag2);
+  edges_.push_back({bag1, bag2});
+}
+
+int TreeDecomposition::NumBags() const {
+  return bags_.size();
+}
+
+const std::vector<int>& TreeDecomposition::Bag(int i) const {
+  return bags_[i];
+}
+
+const std::vector<Edge>& TreeDecomposition::Edges() const {
+  return edges_;
+}
+
+int TreeDecomposition::Width() const {
+  int width = -1;
+  for (const auto& bag : bags_) width = std::max(width, (int)bag.size() - 1);
+  return width;
+}
+
+void TreeDecomposition::MapBack(const Graph& graph) {
+  std::vector<std::vector<int> > bags;
+  bags.swap(bags_);
+  bags_of_.clear();
+  for (const auto& bag : bags) AddBag(graph.MapBack(bag));
+}
+
+int TreeDecomposition::FindBagContaining(const std::vector<int>& vs) const {
+  if (vs.empty()) return bags_.empty() ? -1 : 0;
+  // Scan the bags of the vertex that is in the fewest bags
+  int rarest = -1;
+  for (int v : vs) {
+    if (v >= (int)bags_of_.size() || bags_of_[v].empty()) return -1;
+    if (rarest == -1 || bags_of_[v].size() < bags_of_[rarest].size()) rarest = v;
+  }
+  for (int b : bags_of_[rarest]) {
+    if (std::includes(bags_[b].begin(), bags_[b].end(), vs.begin(), vs.end())) return b;
+  }
+  return -1;
+}
+
+void TreeDecomposition::Glue(const TreeDecomposition& other) {
+  if (other.bags_.empty()) return;
+  std::vector<int> common;
+  for (const auto& bag : other.bags_) {
+    for (int v : bag) {
+      if (v < (int)bags_of_.size() && !bags_of_[v].empty()) common.push_back(v);
+    }
+  }
+  std::sort(common.begin(), common.end());
+  common.erase(std::unique(common.begin(), common.end()), common.end());
+  int attach = FindBagContaining(common);
+  int other_attach = other.FindBagContaining(common);
+  assert(other_attach >= 0);
+  assert(attach >= 0 || bags_.empty());
+  int offset = bags_.size();
+  for (const auto& bag : other.bags_) AddBag(bag);
+  for (const Edge& edge : other.edges_) edges_.push_back({edge.first + offset, edge.second + offset});
+  if (attach >= 0) AddEdge(attach, other_attach + offset);
+}
+
+void TreeDecomposition::AddMissingVertices(int n) {
+  for (int v = 0; v < n; v++) {
+    if (v < (int)bags_of_.size() && !bags_of_[v].empty()) continue;
+    int bag = AddBag({v});
+    if (bag > 0) AddEdge(0, bag);
+  }
+}
+
+bool TreeDecomposition::IsValid(const Graph& graph) const {
+  if (bags_.empty()) return graph.n() == 0;
+  if ((int)edges_.size() != NumBags() - 1) return false;
+  std::vector<std::vector<int> > tree(NumBags());
+  for (const Edge& edge : edges_) {
+    tree[edge.first].push_back(edge.second);
+    tree[edge.second].push_back(edge.first);
+  }
+  std::vector<char> in_subtree(NumBags());
+  std::queue<int> queue;
+  queue.push(0);
+  in_subtree[0] = 1;
+  int reached = 0;
+  while (!queue.empty()) {
+    int b = queue.front();
+    queue.pop();
+    reached++;
+    for (int nb : tree[b]) {
+      if (!in_subtree[nb]) {
+        in_subtree[nb] = 1;
+        queue.push(nb);
+      }
+    }
+  }
+  if (reached != NumBags()) return false;
+  std::fill(in_subtree.begin(), in_subtree.end(), 0);
+  // In a tree, the bags of a vertex are connected iff the subgraph they induce has one less edge than bags
+  auto connected = [&](const std::vector<int>& bags) {
+    for (int b : bags) in_subtree[b] = 1;
+    int edges = 0;
+    for (int b : bags) {
+      for (int nb : tree[b]) edges += in_subtree[nb];
+    }
+    for (int b : bags) in_subtree[b] = 0;
+    return edges == 2 * ((int)bags.size() - 1);
+  };
+  for (int v = 0; v < graph.n(); v++) {
+    if (v >= (int)bags_of_.size() || bags_of_[v].empty()) return false;
+    if (!connected(bags_of_[v])) return false;
+  }
+  for (const Edge& edge : graph.Edges()) {
+    if (FindBagContaining({std::min(edge.first, edge.second), std::max(edge.first, edge.second)}) == -1) return false;
+  }
+  return true;
+}
+} // namespace triangulator
@@ -0,0 +1,43 @@
+#pragma once
+
+// Tree decompositions as a list of bags and the edges of the tree between them.
+// Built from the BT reconstruction and from the preprocessing rules, and glued together along cliques.
+
+#include <vector>
+
+#include "graph.hpp"
+
+namespace triangulator {
+
+class TreeDecomposition {
+public:
+  // Returns the index of the new bag. The bag is sorted.
+  int AddBag(std::vector<int> bag);
+  void AddEdge(int bag1, int bag2);
+
+  int NumBags() const;
+  const std::vector<int>& Bag(int i) const;
+  const std::vector<Edge>& Edges() const;
+  // The largest bag size minus one, or -1 for the empty decomposition
+  int Width() const;
+
+  // Maps the vertices of the bags from graph to its parent graph
+  void MapBack(const Graph& graph);
+  // Adds the bags of other and connects the two trees by an edge. The common vertices of the two decompositions must
+  // be contained in a bag of both of them, which holds if they form a clique in both.
+  void Glue(const TreeDecomposition& other);
+  // Adds a bag of one vertex for each vertex 0..n-1 not in any bag
+  void AddMissingVertices(int n);
+
+  // Returns whether this is a tree decomposition of graph
+  bool IsValid(const Graph& graph) const;
+private:
+  std::vector<std::vector<int> > bags_;
+  std::vector<Edge> edges_;
+  // The bags containing each vertex
+  std::vector<std::vector<int> > bags_of_;
+
+  // Returns a bag containing the sorted vertices vs, or -1 if there is none
+  int FindBagContaining(const std::vector<int>& vs) const;
+};
+} // namespace triangulator
@@ -3,14 +3,19 @@
 #include <vector>
 #include <cassert>
 #include <queue>
+#include <memory>
+#include <algorithm>
 
 #include "graph.hpp"
 #include "mcs.hpp"
+#include "tree_decomposition.hpp"
 
 namespace triangulator {
 namespace {
 
-std::vector<Edge> GreedyDegree2(Graph& graph) {
+// Eliminates vertices of degree at most 2. The bags of the eliminated vertices are added to bags in the order of
+// elimination.
+std::vector<Edge> GreedyDegree2(Graph& graph, std::vector<std::vector<int> >& bags) {
   std::queue<int> d2;
   for (int i = 0; i < graph.n(); i++) {
     assert(graph.Neighbors(i).size() > 1);
@@ -23,10 +28,12 @@ std::vector<Edge> GreedyDegree2(Graph& graph) {
     int x = d2.front();
     d2.pop();
     if (graph.Neighbors(x).size() == 1) {
+      bags.push_back({x, graph.Neighbors(x)[0]});
       graph.RemoveEdge(x, graph.Neighbors(x)[0]);
     } else if (graph.Neighbors(x).size() == 2) {
       int nb1 = graph.Neighbors(x)[0];
       int nb2 = graph.Neighbors(x)[1];
+      bags.push_back({x, nb1, nb2});
       graph.RemoveEdge(x, nb1);
       graph.RemoveEdge(x, nb2);
       if (!graph.HasEdge(nb1, nb2)) {
@@ -77,24 +84,35 @@ Edge NeighborClique(Graph& graph) {
 }
 } // namespace
 
-TreewidthPreprocessor::TreewidthPreprocessor(const Graph& graph) : orig_graph_(graph) { }
+TreewidthPreprocessor::TreewidthPreprocessor(const Graph& graph) : orig_graph_(std::make_shared<const Graph>(graph)) { }
 
 std::vector<TreewidthInstance> TreewidthPreprocessor::Preprocess(bool pp) {
   lower_bound_ = 0;
   instances_.clear();
   fill_edges_.clear();
+  parts_.clear();
+  instance_parts_.clear();
   if (pp) {
-    Preprocess1(orig_graph_);
+    Preprocess1(*orig_graph_);
   } else {
     TreewidthInstance instance{orig_graph_, (int)1e9, {}};
+    instance_parts_.push_back(AddPart(0, {}, {}));
     instances_.push_back(instance);
   }
   std::vector<TreewidthInstance> ret_instances;
-  for (auto& t_instance : instances_) {
+  for (int i = 0; i < (int)instances_.size(); i++) {
+    const TreewidthInstance& t_instance = instances_[i];
+    DecompositionPart& part = parts_[instance_parts_[i]];
     if (lower_bound_ >= t_instance.upper_bound) {
-      std::vector<Edge> fill = t_instance.graph.MapBack(t_instance.upper_bound_fill);
+      std::vector<Edge> fill = t_instance.graph->MapBack(t_instance.upper_bound_fill);
       fill_edges_.insert(fill_edges_.end(), fill.begin(), fill.end());
+      Graph filled = *t_instance.graph;
+      filled.AddEdges(t_instance.upper_bound_fill);
+      part.instance = -1;
+      part.decomposition = mcs::ChordalDecomposition(filled);
+      part.decomposition.MapBack(*t_instance.graph);
     } else {
+      part.instance = ret_instances.size();
       ret_instances.push_back(t_instance);
     }
   }
@@ -102,16 +120,23 @@ std::vector<TreewidthInstance> TreewidthPreprocessor::Preprocess(bool pp) {
   return instances_;
 }
 
-void TreewidthPreprocessor::Preprocess1(Graph graph) {
+int TreewidthPreprocessor::AddPart(int instance, TreeDecomposition decomposition, std::vector<int> children) {
+  parts_.push_back({instance, std::move(decomposition), std::move(children)});
+  return parts_.size() - 1;
+}
+
+int TreewidthPreprocessor::Preprocess1(const Graph& graph) {
   mcs::McsMOutput minimal_triangulation = mcs::McsM(graph);
   auto fill = minimal_triangulation.fill_edges;
   Graph filled = graph;
   filled.AddEdges(fill);
   if (fill.size() <= 1) {
     lower_bound_ = std::max(lower_bound_, mcs::Treewidth(filled));
+    TreeDecomposition decomposition = mcs::ChordalDecomposition(filled);
+    decomposition.MapBack(graph);
     fill = graph.MapBack(fill);
     fill_edges_.insert(fill_edges_.end(), fill.begin(), fill.end());
-    return;
+    return AddPart(-1, std::move(decomposition), {});
   }
   std::vector<Graph> atoms = mcs::Atoms(graph, minimal_triangulation);
   if (atoms.size() == 1) {
@@ -119,31 +144,47 @@ void TreewidthPreprocessor::Preprocess1(Graph graph) {
     assert(min_degree >= 2);
     lower_bound_ = std::max(lower_bound_, min_degree);
     atoms[0].InheritMap(graph);
-    TreewidthInstance instance{atoms[0], mcs::Treewidth(filled), fill};
-    Preprocess2(instance);
+    return Preprocess2(std::move(atoms[0]), mcs::Treewidth(filled), fill);
   } else {
+    // Each atom meets the atoms found after it in its clique separator, so gluing them in reverse order connects
+    // the decompositions along cliques
+    std::vector<int> children;
     for (Graph& atom : atoms) {
       atom.InheritMap(graph);
-      Preprocess1(atom);
+      children.push_back(Preprocess1(atom));
     }
+    std::reverse(children.begin(), children.end());
+    return AddPart(-1, {}, std::move(children));
   }
 }
 
-void TreewidthPreprocessor::Preprocess2(TreewidthInstance instance) {
-  auto fill_d2 = GreedyDegree2(instance.graph);
+int TreewidthPreprocessor::Preprocess2(Graph graph, int upper_bound, const std::vector<Edge>& upper_bound_fill) {
+  std::vector<std::vector<int> > bags_d2;
+  auto fill_d2 = GreedyDegree2(graph, bags_d2);
   if (fill_d2.size() > 0) {
-    fill_d2 = instance.graph.MapBack(fill_d2);
+    fill_d2 = graph.MapBack(fill_d2);
     fill_edges_.insert(fill_edges_.end(), fill_d2.begin(), fill_d2.end());
-    Preprocess1(instance.graph);
-    return;
+    // The neighbors of an eliminated vertex form a clique in the graph that remains after it, so the bags are glued
+    // in reverse order of elimination
+    std::vector<int> children = {Preprocess1(graph)};
+    for (int i = (int)bags_d2.size() - 1; i >= 0; i--) {
+      TreeDecomposition decomposition;
+      decomposition.AddBag(graph.MapBack(bags_d2[i]));
+      children.push_back(AddPart(-1, std::move(decomposition), {}));
+    }
+    return AddPart(-1, {}, std::move(children));
   }
-  auto nb_c_fill = NeighborClique(instance.graph);
+  // A vertex of degree 2 with adjacent neighbors would be separated by a clique, so nothing was eliminated
+  assert(bags_d2.empty());
+  auto nb_c_fill = NeighborClique(graph);
   if (nb_c_fill.first != -1) {
-    fill_edges_.push_back(instance.graph.MapBack(nb_c_fill));
-    Preprocess1(instance.graph);
-    return;
+    fill_edges_.push_back(graph.MapBack(nb_c_fill));
+    return Preprocess1(graph);
   }
+  TreewidthInstance instance{std::make_shared<const Graph>(std::move(graph)), upper_bound, upper_bound_fill};
+  instance_parts_.push_back(AddPart(instances_.size(), {}, {}));
   instances_.push_back(instance);
+  return instance_parts_.back();
 }
 
 TreewidthSolution TreewidthPreprocessor::MapBack(const std::vector<TreewidthSolution>& solutions) const {
@@ -154,7 +195,7 @@ TreewidthSolution TreewidthPreprocessor::MapBack(const std::vector<TreewidthSolu
   solution.fill_edges = fill_edges_;
   for (int i = 0; i < is; i++) {
     solution.treewidth = std::max(solution.treewidth, solutions[i].treewidth);
-    auto this_fill = instances_[i].graph.MapBack(solutions[i].fill_edges);
+    auto this_fill = instances_[i].graph->MapBack(solutions[i].fill_edges);
     solution.fill_edges.insert(solution.fill_edges.end(), this_fill.begin(), this_fill.end());
   }
   for (auto& edge : solution.fill_edges) {
@@ -164,13 +205,26 @@ TreewidthSolution TreewidthPreprocessor::MapBack(const std::vector<TreewidthSolu
   for (int i = 1; i < solution.fill_edges.size(); i++) {
     assert(solution.fill_edges[i] != solution.fill_edges[i - 1]);
   }
-  Graph final_fill = orig_graph_;
-  for (auto edge : solution.fill_edges) {
-    assert(edge.first >= 0 && edge.first < final_fill.n() && edge.second >= 0 && edge.second < final_fill.n());
-    assert(!final_fill.HasEdge(edge));
-    final_fill.AddEdge(edge);
+  // The children of a part are created before it, so the parts are complete when they are reached in order
+  std::vector<TreeDecomposition> decompositions(parts_.size());
+  for (int i = 0; i < (int)parts_.size(); i++) {
+    const DecompositionPart& part = parts_[i];
+    if (part.instance >= 0) {
+      decompositions[i] = solutions[part.instance].decomposition;
+      decompositions[i].MapBack(*instances_[part.instance].graph);
+    } else {
+      decompositions[i] = part.decomposition;
+    }
+    for (int child : part.children) {
+      assert(child < i);
+      decompositions[i].Glue(decompositions[child]);
+      decompositions[child] = TreeDecomposition();
+    }
   }
-  assert(solution.treewidth == mcs::Treewidth(final_fill));
+  solution.decomposition = std::move(decompositions.back());
+  solution.decomposition.AddMissingVertices(orig_graph_->n());
+  assert(std::max(solution.decomposition.Width(), 0) == solution.treewidth);
+  assert(solution.decomposition.IsValid(*orig_graph_));
   return solution;
 }
 } // namespace triangulator
\ No newline at end of file
@@ -5,11 +5,12 @@
 
 #include "graph.hpp"
 #include "mcs.hpp"
+#include "tree_decomposition.hpp"
 
 namespace triangulator {
 
 struct TreewidthInstance {
-  Graph graph;
+  SharedGraph graph;
   int upper_bound;
   std::vector<Edge> upper_bound_fill;
 };
@@ -17,6 +18,8 @@ struct TreewidthInstance {
 struct TreewidthSolution {
   std::vector<Edge> fill_edges;
   int treewidth;
+  // A tree decomposition of width treewidth whose bags are cliques of the filled graph
+  TreeDecomposition decomposition;
 };
 
 class TreewidthPreprocessor {
@@ -28,8 +31,20 @@ private:
   std::vector<TreewidthInstance> instances_;
   std::vector<Edge> fill_edges_;
   int lower_bound_;
-  const Graph orig_graph_;
-  void Preprocess1(Graph graph);
-  void Preprocess2(TreewidthInstance instance);
+  const SharedGraph orig_graph_;
+  // The decomposition of the original graph is assembled from parts that follow the recursion of the preprocessing.
+  // A part is the decomposition of instance, or a known decomposition if instance is -1, glued with the parts of
+  // children in order. The vertices of the known decompositions are those of the original graph.
+  struct DecompositionPart {
+    int instance;
+    TreeDecomposition decomposition;
+    std::vector<int> children;
+  };
+  std::vector<DecompositionPart> parts_;
+  std::vector<int> instance_parts_;
+  int AddPart(int instance, TreeDecomposition decomposition, std::vector<int> children);
+  // Both return the part of graph
+  int Preprocess1(const Graph& graph);
+  int Preprocess2(Graph graph, int upper_bound, const std::vector<Edge>& upper_bound_fill);
 };
 } // namespace triangulator
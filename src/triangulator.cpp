@@ -11,8 +11,33 @@
 #include "io.hpp"
 #include "tests.hpp"
 #include "solver.hpp"
+#include "bt_algorithm.hpp"
+#include "external_bt_algorithm.hpp"
+#include "tree_decomposition.hpp"
+#include "enumerator.hpp"
 
 int main(int argc, char** argv) {
+  // Options can be given anywhere on the command line and are removed before the positional arguments are read
+  std::vector<char*> args;
+  std::string td_file;
+  for (int i = 0; i < argc; i++) {
+    std::string arg(argv[i]);
+    if (arg.compare(0, 13, "--bt-threads=") == 0) {
+      triangulator::BtAlgorithmBase::SetThreads(std::stoi(arg.substr(13)));
+    } else if (arg.compare(0, 14, "--bt-external=") == 0) {
+      triangulator::ExternalBtAlgorithmBase::SetRunBytes(std::stoull(arg.substr(14)) << 20);
+    } else if (arg.compare(0, 15, "--seed-minseps=") == 0) {
+      triangulator::Enumerator::SetSeedMinseps(std::stoi(arg.substr(15)));
+    } else if (arg == "--multi-minseps") {
+      triangulator::Enumerator::SetMultipleMinseps(true);
+    } else if (arg.compare(0, 5, "--td=") == 0) {
+      td_file = arg.substr(5);
+    } else {
+      args.push_back(argv[i]);
+    }
+  }
+  argc = args.size();
+  argv = args.data();
   if (argc < 2) triangulator::utils::ErrorDie("Give problem as the first argument.");
   std::string farg(argv[1]);
   std::set<std::string> solvers = {"minisat", "cryptominisat", "ipasir", "asp", "comb", "glucose", "mapleglucose", "glucosenopp", "minisatnopp"};
@@ -34,21 +59,26 @@ int main(int argc, char** argv) {
     std::ifstream input(file);
     triangulator::Graph graph = io.ReadGraph(input);
     int sol;
+    triangulator::TreeDecomposition decomposition;
     if (solver == "asp"){
       assert(argc == 4);
-      sol = triangulator::TreewidthAsp(graph, pp);
+      sol = triangulator::TreewidthAsp(graph, pp, &decomposition);
     } else if (solver == "comb") {
       assert(argc == 4);
-      sol = triangulator::TreewidthComb(graph, pp);
+      sol = triangulator::TreewidthComb(graph, pp, &decomposition);
     } else {
       assert(argc == 6);
       int ms_enc = std::stoi(argv[4]);
       int card_enc = std::stoi(argv[5]);
-      assert(ms_enc >= 0 && ms_enc <= 5);
+      assert(ms_enc >= 0 && ms_enc <= 8);
       assert(card_enc >= 0 && card_enc <= 1);
-      sol = triangulator::TreewidthSat(graph, ms_enc, card_enc, solver, pp);
+      sol = triangulator::TreewidthSat(graph, ms_enc, card_enc, solver, pp, &decomposition);
     }
     std::cout << sol << std::endl;
+    if (!td_file.empty()) {
+      std::ofstream td_output(td_file);
+      io.WriteTreeDecomposition(td_output, decomposition);
+    }
   } else if (farg == "ghtw") {
     assert(argc >= 4);
     std::string solver(argv[2]);
@@ -68,11 +98,44 @@ int main(int argc, char** argv) {
       assert(argc == 6);
       int ms_enc = std::stoi(argv[4]);
       int card_enc = std::stoi(argv[5]);
-      assert(ms_enc >= 0 && ms_enc <= 5);
+      assert(ms_enc >= 0 && ms_enc <= 8);
       assert(card_enc >= 0 && card_enc <= 1);
       sol = triangulator::HypertreewidthSat(hypergraph, ms_enc, card_enc, solver);
     }
     std::cout << sol << std::endl;
+  } else if (farg == "fillin") {
+    assert(argc == 4);
+    std::string solver(argv[2]);
+    std::string file(argv[3]);
+    assert(solver == "comb");
+    triangulator::Io io;
+    std::ifstream input(file);
+    triangulator::Graph graph = io.ReadGraph(input);
+    long long sol = triangulator::MinimumFillInComb(graph);
+    std::cout << sol << std::endl;
+  } else if (farg == "tablesize") {
+    assert(argc >= 5);
+    std::string objective(argv[2]);
+    std::string solver(argv[3]);
+    std::string file(argv[4]);
+    assert(objective == "max" || objective == "total");
+    assert(solvers.find(solver) != solvers.end() && solver != "asp");
+    triangulator::Io io;
+    std::ifstream input(file);
+    triangulator::Graph graph = io.ReadGraph(input);
+    long long sol;
+    if (solver == "comb") {
+      assert(argc == 5);
+      sol = triangulator::TableSizeComb(graph, objective == "total");
+    } else {
+      assert(argc == 7);
+      int ms_enc = std::stoi(argv[5]);
+      int card_enc = std::stoi(argv[6]);
+      assert(ms_enc >= 0 && ms_enc <= 8);
+      assert(card_enc >= 0 && card_enc <= 1);
+      sol = triangulator::TableSizeSat(graph, objective == "total", ms_enc, card_enc, solver);
+    }
+    std::cout << sol << std::endl;
   } else if (farg == "countminseps") {
     assert(argc == 4);
     int ub = std::stoi(argv[2]);
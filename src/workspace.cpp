@@ -0,0 +1 @@
+#include "workspace.hpp"
@@ -0,0 +1,55 @@
+#pragma once
+
+// Reusable buffers for graph traversals. Once the buffers have grown to the size of the graph the traversals do not allocate.
+
+#include <vector>
+#include <algorithm>
+
+namespace triangulator {
+// Interface
+
+// Set of marked vertices that is cleared in O(1) by advancing an epoch
+class VertexMarks {
+public:
+  VertexMarks();
+  // Unmarks all vertices and makes sure that the vertices 0..n-1 can be marked
+  void Clear(int n);
+  bool Has(int v) const;
+  void Set(int v);
+private:
+  std::vector<unsigned> mark_;
+  unsigned epoch_;
+};
+
+struct TraversalWorkspace {
+  // Vertices that the traversal does not enter. Traversed vertices are added to this.
+  VertexMarks blocked;
+  // Vertices seen by the current traversal
+  VertexMarks seen;
+  // The vertices of the last traversed component. Also used as the worklist of the traversal.
+  std::vector<int> component;
+  // The vertices that were blocked before the last traversal and are adjacent to the component
+  std::vector<int> neighbors;
+};
+
+
+// Implementation
+inline VertexMarks::VertexMarks() : epoch_(0) { }
+
+inline void VertexMarks::Clear(int n) {
+  if ((int)mark_.size() < n) mark_.resize(n, 0);
+  epoch_++;
+  if (epoch_ == 0) {
+    std::fill(mark_.begin(), mark_.end(), 0);
+    epoch_ = 1;
+  }
+}
+
+inline bool VertexMarks::Has(int v) const {
+  return mark_[v] == epoch_;
+}
+
+inline void VertexMarks::Set(int v) {
+  mark_[v] = epoch_;
+}
+} // namespace triangulator